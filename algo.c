@@ -19,8 +19,7 @@ static void strat_euler_run(const Graph *g, EmitFn emit, void *ctx) {
         emitf(emit, ctx, "No Euler circuit: graph is disconnected among non-isolated vertices.\n");
         return;
     }
-    int odd = 0;
-    for (int i = 0; i < g->V; ++i) if (degree(g, i) % 2 != 0) odd++;
+    int odd = g->odd;
     if (odd != 0) {
         emitf(emit, ctx, "No Euler circuit: %d vertices have odd degree.\n", odd);
         return;
@@ -38,16 +37,18 @@ static void strat_euler_run(const Graph *g, EmitFn emit, void *ctx) {
 }
 
 static void strat_mst_run(const Graph *g, EmitFn emit, void *ctx) {
-    long long w = mst_weight_prim(g);
-    if (w < 0) emitf(emit, ctx, "MST: graph is not connected (no spanning tree)\n");
-    else       emitf(emit, ctx, "MST total weight: %lld\n", w);
+    if (g->ncomp == 1) { emitf(emit, ctx, "MST total weight: %lld\n", mst_weight(g, 1, NULL)); return; }
+    emitf(emit, ctx, "MST: graph is not connected (%d components); minimum spanning forest:\n", g->ncomp);
+    emitf(emit, ctx, "Forest total weight: %lld\n", mst_forest(g, 1, NULL));
 }
 
-static void strat_maxclique_run(const Graph *g, EmitFn emit, void *ctx) {
+typedef int (*CliqueFn)(const Graph*, int*, int*);
+
+static void emit_max_clique(const Graph *g, CliqueFn fn, EmitFn emit, void *ctx) {
     int *cl = (int*)malloc((size_t)g->V * sizeof(int));
     if (!cl) { emitf(emit, ctx, "ERR: out of memory\n"); return; }
     int got = 0;
-    int k = max_clique(g, cl, &got);
+    int k = fn(g, cl, &got);
     emitf(emit, ctx, "Max clique size = %d\n", k);
     if (got > 0) {
         emitf(emit, ctx, "Vertices: ");
@@ -57,13 +58,54 @@ static void strat_maxclique_run(const Graph *g, EmitFn emit, void *ctx) {
     free(cl);
 }
 
+static void strat_maxclique_run(const Graph *g, EmitFn emit, void *ctx) {
+    emit_max_clique(g, max_clique, emit, ctx);
+}
+
+static void strat_maxcliquebb_run(const Graph *g, EmitFn emit, void *ctx) {
+    emit_max_clique(g, max_clique_bb, emit, ctx);
+}
+
 static void strat_countclq3p_run(const Graph *g, EmitFn emit, void *ctx) {
-    long long cnt = count_cliques_3plus(g);
-    emitf(emit, ctx, "Number of cliques (size >= 3): %lld\n", cnt);
+    unsigned __int128 cnt;
+    char num[40];
+    if (count_cliques_3plus_exact(g, &cnt) == 0)
+        emitf(emit, ctx, "Number of cliques (size >= 3): %s\n", u128_to_str(cnt, num));
+    else
+        emitf(emit, ctx, "Number of cliques (size >= 3): more than 2^128\n");
+}
+
+static void strat_countclq_run(const Graph *g, EmitFn emit, void *ctx) {
+    unsigned __int128 *hist = malloc(((size_t)g->V + 2) * sizeof(*hist)), total = 0;
+    if (!hist) { emitf(emit, ctx, "ERR: out of memory\n"); return; }
+    int n = count_cliques_by_size(g, hist), over = 0;
+    char num[40];
+    if (n < 0) {
+        emitf(emit, ctx, "Clique counts by size: more than 2^128 cliques of some size\n");
+        free(hist);
+        return;
+    }
+    emitf(emit, ctx, "Clique counts by size (k: count):\n");
+    for (int k = 3; k < n; ++k) {
+        emitf(emit, ctx, "%d: %s\n", k, u128_to_str(hist[k], num));
+        over |= __builtin_add_overflow(total, hist[k], &total);
+    }
+    if (over) emitf(emit, ctx, "Total (size >= 3): more than 2^128\n");
+    else      emitf(emit, ctx, "Total (size >= 3): %s\n", u128_to_str(total, num));
+    free(hist);
+}
+
+static void strat_counttri_run(const Graph *g, EmitFn emit, void *ctx) {
+    emitf(emit, ctx, "Triangles: %lld\n", count_triangles(g, 1, NULL));
 }
 
 static void strat_hamilton_run(const Graph *g, EmitFn emit, void *ctx) {
     int *cyc = NULL, L = 0;
+    char why[128];
+    if (hamilton_obstruction(g, why, sizeof(why))) {
+        emitf(emit, ctx, "No Hamiltonian cycle: %s.\n", why);
+        return;
+    }
     if (!hamilton_cycle(g, &cyc, &L)) {
         emitf(emit, ctx, "No Hamiltonian cycle.\n");
         return;
@@ -79,7 +121,10 @@ static const Pair TABLE[] = {
     {"EULER",      strat_euler_run},
     {"MST",        strat_mst_run},
     {"MAXCLIQUE",  strat_maxclique_run},
+    {"MAXCLIQUEBB", strat_maxcliquebb_run},
     {"COUNTCLQ3P", strat_countclq3p_run},
+    {"COUNTCLQ",   strat_countclq_run},
+    {"COUNTTRI",   strat_counttri_run},
     {"HAMILTON",   strat_hamilton_run},
 };
 
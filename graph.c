@@ -1,4 +1,5 @@
 #define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE
 #include "graph.h"
 
 #include <stdio.h>
@@ -10,51 +11,252 @@
 #include <limits.h>
 #include <math.h>   
 #include <stdint.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 #ifndef GRAPH_RAND_WMAX
 #define GRAPH_RAND_WMAX 100  
 #endif
+#ifndef GRAPH_CSR_RATIO
+#define GRAPH_CSR_RATIO 4            /* dense must cost this many times more */
+#endif
+#ifndef GRAPH_CSR_MIN_BYTES
+#define GRAPH_CSR_MIN_BYTES (1 << 20) /* small graphs always stay dense */
+#endif
+#ifndef GRAPH_GEN_BLOCK
+#define GRAPH_GEN_BLOCK (1LL << 16)  /* pair indices per random-graph stream */
+#endif
+#ifndef GRAPH_MST_PRIM_RATIO
+#define GRAPH_MST_PRIM_RATIO 8       /* dense Prim once E >= V^2 / ratio */
+#endif
+#ifndef GRAPH_MST_PAR_MIN_EDGES
+#define GRAPH_MST_PAR_MIN_EDGES 200000
+#endif
+#ifndef GRAPH_HAM_DP_MAX_V
+#define GRAPH_HAM_DP_MAX_V 26        /* Held-Karp up to here: 2^(V-1) words, 128 MiB at 26 */
+#endif
+_Static_assert(GRAPH_HAM_DP_MAX_V <= 32, "ham_dp keeps path ends in 32-bit words");
+#ifndef GRAPH_USE_THP
+#define GRAPH_USE_THP 1              /* back big arenas with huge pages */
+#endif
+#define GRAPH_CACHELINE   64
+#define GRAPH_THP_BYTES   (2u << 20)
+
+/* Zeroed, cache-line-aligned block. Blocks of at least one huge page are
+   mmap'ed on a 2 MiB boundary and advised for transparent huge pages. */
+static void* arena_alloc(size_t bytes, int *mapped) {
+    *mapped = 0;
+#if GRAPH_USE_THP && defined(MAP_ANONYMOUS)
+    if (bytes >= GRAPH_THP_BYTES) {
+        size_t len = bytes + GRAPH_THP_BYTES;
+        char *raw = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) { perror("mmap"); exit(1); }
+        uintptr_t a = ((uintptr_t)raw + GRAPH_THP_BYTES - 1) & ~(uintptr_t)(GRAPH_THP_BYTES - 1);
+        size_t head = (size_t)(a - (uintptr_t)raw), tail = len - head - bytes;
+        if (head) munmap(raw, head);
+        if (tail) munmap((char*)a + bytes, tail);
+#ifdef MADV_HUGEPAGE
+        (void)madvise((void*)a, bytes, MADV_HUGEPAGE);
+#endif
+        *mapped = 1;
+        return (void*)a;
+    }
+#endif
+    void *p = NULL;
+    if (posix_memalign(&p, GRAPH_CACHELINE, bytes ? bytes : 1) != 0) {
+        perror("posix_memalign"); exit(1);
+    }
+    memset(p, 0, bytes);
+    return p;
+}
+
+static void arena_free(void *p, size_t bytes, int mapped) {
+    if (!p) return;
+    if (mapped) munmap(p, bytes);
+    else        free(p);
+}
+
 
+/* Degree, parity and union-find bookkeeping share one block of 3V ints.
+   Every vertex starts isolated and as its own component. */
+static void meta_init(Graph *g) {
+    const int V = g->V;
+    g->deg = calloc(3 * (size_t)V + 1, sizeof(int));
+    if (!g->deg) { perror("calloc"); exit(1); }
+    g->uf   = g->deg + V;
+    g->ufsz = g->deg + 2 * (size_t)V;
+    for (int i = 0; i < V; ++i) { g->uf[i] = i; g->ufsz[i] = 1; }
+    g->odd = 0;
+    g->isolated = V;
+    g->ncomp = V;
+}
+
+static int uf_find(int *uf, int u) {
+    while (uf[u] != u) { uf[u] = uf[uf[u]]; u = uf[u]; }
+    return u;
+}
 
+/* Updates degree, parity, isolation and component counts for a new edge. */
+static void meta_add_edge(Graph *g, int u, int v) {
+    if (g->deg[u]++ == 0) g->isolated--;
+    if (g->deg[v]++ == 0) g->isolated--;
+    g->odd += (g->deg[u] & 1) ? 1 : -1;
+    g->odd += (g->deg[v] & 1) ? 1 : -1;
+
+    int a = uf_find(g->uf, u), b = uf_find(g->uf, v);
+    if (a == b) return;
+    if (g->ufsz[a] < g->ufsz[b]) { int t = a; a = b; b = t; }
+    g->uf[b] = a;
+    g->ufsz[a] += g->ufsz[b];
+    g->ncomp--;
+}
+
+/* All dense storage lives in one arena: the weight row-pointer table, the
+   packed adjacency bit matrix and the weight matrix. Bit rows and weight
+   rows are padded to whole cache lines, so every row starts aligned and
+   row-major scans stream through memory. */
 Graph* create_graph(int V) {
-    Graph *g = malloc(sizeof(Graph));
-    if (!g) { perror("malloc"); exit(1); }
+    Graph *g = calloc(1, sizeof(Graph));
+    if (!g) { perror("calloc"); exit(1); }
     g->V = V;
     g->E = 0;
 
-    g->adj = malloc(V * sizeof(int*));
-    if (!g->adj) { perror("malloc"); exit(1); }
-    g->w   = malloc(V * sizeof(int*));
-    if (!g->w)   { perror("malloc"); exit(1); }
+    const size_t words_per_line = GRAPH_CACHELINE / sizeof(uint64_t);
+    const size_t ints_per_line  = GRAPH_CACHELINE / sizeof(int);
+    const size_t words  = (((size_t)V + 63) / 64 + words_per_line - 1) / words_per_line * words_per_line;
+    const size_t stride = ((size_t)V + ints_per_line - 1) / ints_per_line * ints_per_line;
+    size_t ptrs = (size_t)V * sizeof(int*);
+    ptrs = (ptrs + GRAPH_CACHELINE - 1) / GRAPH_CACHELINE * GRAPH_CACHELINE;
+    const size_t bits   = (size_t)V * words * sizeof(uint64_t);
+    const size_t matrix = (size_t)V * stride * sizeof(int);
+
+    g->arena_bytes = ptrs + bits + matrix;
+    char *base = arena_alloc(g->arena_bytes, &g->arena_mapped);
+    g->arena = base;
+
+    g->w     = (int**)base;
+    g->bits  = (uint64_t*)(base + ptrs);
+    g->words = (int)words;
+    g->wstride = (int)stride;
+    int *w_rows = (int*)(base + ptrs + bits);
+    for (int i = 0; i < V; ++i) g->w[i] = w_rows + (size_t)i * stride;
+    meta_init(g);
+    return g;
+}
+
+Graph* create_graph_csr(int V) {
+    Graph *g = calloc(1, sizeof(Graph));
+    if (!g) { perror("calloc"); exit(1); }
+    g->V = V;
+    g->E = 0;
+    g->csr = 1;
 
-    for (int i = 0; i < V; ++i) {
-        g->adj[i] = calloc(V, sizeof(int));
-        if (!g->adj[i]) { perror("calloc"); exit(1); }
-        g->w[i] = calloc(V, sizeof(int));
-        if (!g->w[i]) { perror("calloc"); exit(1); }
-    }
+    g->off = calloc((size_t)V + 1, sizeof(int));
+    if (!g->off) { perror("calloc"); exit(1); }
+    meta_init(g);
     return g;
 }
 
+/* Dense storage costs V*V weight ints plus V*V adjacency bits; CSR costs
+   roughly 13 ints per edge (edge list, dedup set, two row entries with
+   weight and edge id). */
+int graph_prefers_csr(int V, long long E) {
+    const double dense = (double)V * (double)V * (sizeof(int) + 1.0 / 8.0);
+    const double csr   = ((double)V + 13.0 * (double)E) * sizeof(int);
+    return dense > (double)GRAPH_CSR_MIN_BYTES && dense > GRAPH_CSR_RATIO * csr;
+}
+
+Graph* create_graph_sized(int V, long long E) {
+    return graph_prefers_csr(V, E) ? create_graph_csr(V) : create_graph(V);
+}
+
 void free_graph(Graph *g) {
     if (!g) return;
-    for (int i = 0; i < g->V; ++i) {
-        free(g->adj[i]);
-        free(g->w[i]);
-    }
-    free(g->adj);
-    free(g->w);
+    arena_free(g->arena, g->arena_bytes, g->arena_mapped);
+    free(g->off); free(g->nbr); free(g->nw); free(g->eid);
+    free(g->eu);  free(g->ev);  free(g->ew);
+    free(g->eset);
+    free(g->deg);
     free(g);
 }
 
+static inline uint64_t edge_key(int u, int v) {
+    if (u > v) { int t = u; u = v; v = t; }
+    return ((uint64_t)(uint32_t)u << 32) | (uint32_t)v;   /* never 0: u < v */
+}
+static inline size_t edge_hash(uint64_t k, size_t mask) {
+    k ^= k >> 33; k *= UINT64_C(0xff51afd7ed558ccd); k ^= k >> 33;
+    return (size_t)k & mask;
+}
+static int eset_contains(const Graph *g, uint64_t k) {
+    if (!g->eset_cap) return 0;
+    size_t mask = g->eset_cap - 1;
+    for (size_t i = edge_hash(k, mask); g->eset[i]; i = (i + 1) & mask)
+        if (g->eset[i] == k) return 1;
+    return 0;
+}
+static void eset_insert(Graph *g, uint64_t k) {
+    if ((size_t)(g->E + 1) * 2 > g->eset_cap) {
+        size_t ncap = g->eset_cap ? g->eset_cap * 2 : 64;
+        uint64_t *ns = calloc(ncap, sizeof(uint64_t));
+        if (!ns) { perror("calloc"); exit(1); }
+        for (size_t j = 0; j < g->eset_cap; ++j) {
+            uint64_t o = g->eset[j];
+            if (!o) continue;
+            size_t i = edge_hash(o, ncap - 1);
+            while (ns[i]) i = (i + 1) & (ncap - 1);
+            ns[i] = o;
+        }
+        free(g->eset);
+        g->eset = ns; g->eset_cap = ncap;
+    }
+    size_t mask = g->eset_cap - 1, i = edge_hash(k, mask);
+    while (g->eset[i]) i = (i + 1) & mask;
+    g->eset[i] = k;
+}
+
+static int csr_add_edge(Graph *g, int u, int v, int w) {
+    uint64_t k = edge_key(u, v);
+    if (eset_contains(g, k)) return 0;
+    eset_insert(g, k);
+
+    if (g->E >= g->ecap) {
+        int ncap = g->ecap ? g->ecap * 2 : 64;
+        g->eu = realloc(g->eu, (size_t)ncap * sizeof(int));
+        g->ev = realloc(g->ev, (size_t)ncap * sizeof(int));
+        g->ew = realloc(g->ew, (size_t)ncap * sizeof(int));
+        if (!g->eu || !g->ev || !g->ew) { perror("realloc"); exit(1); }
+        g->ecap = ncap;
+    }
+    g->eu[g->E] = u; g->ev[g->E] = v; g->ew[g->E] = w;
+    g->E++;
+    meta_add_edge(g, u, v);
+    g->csr_dirty = 1;
+    return 1;
+}
+
+static inline uint64_t* adj_row(const Graph *g, int u) {
+    return g->bits + (size_t)u * (size_t)g->words;
+}
+static inline int adj_test(const Graph *g, int u, int v) {
+    return (int)((adj_row(g, u)[v >> 6] >> (v & 63)) & 1U);
+}
+
 static int add_edge_w(Graph *g, int u, int v, int w) {
     if (u < 0 || v < 0 || u >= g->V || v >= g->V) return 0;
     if (u == v) return 0;              
     if (w <= 0) return 0;              
-    if (g->adj[u][v]) return 0;        
+    if (g->csr) return csr_add_edge(g, u, v, w);
+    if (adj_test(g, u, v)) return 0;        
 
-    g->adj[u][v] = g->adj[v][u] = 1;
+    adj_row(g, u)[v >> 6] |= UINT64_C(1) << (v & 63);
+    adj_row(g, v)[u >> 6] |= UINT64_C(1) << (u & 63);
     g->w[u][v]   = g->w[v][u]   = w;
     g->E++;
+    meta_add_edge(g, u, v);
     return 1;
 }
 
@@ -65,17 +267,100 @@ int graph_add_edge(Graph *g, int u, int v, int w) {
     return add_edge_w(g, u, v, w);
 }
 
+/* Two counting-sort passes: arcs are first bucketed by source, then
+   scattered into target rows in ascending source order, which leaves every
+   row sorted without a comparison sort. */
+void graph_finalize(Graph *g) {
+    if (!g->csr || !g->csr_dirty) return;
+    const int V = g->V, E = g->E;
+    const size_t A = 2 * (size_t)E;
+
+    free(g->nbr); free(g->nw); free(g->eid);
+    g->nbr = malloc((A ? A : 1) * sizeof(int));
+    g->nw  = malloc((A ? A : 1) * sizeof(int));
+    g->eid = malloc((A ? A : 1) * sizeof(int));
+    int *pos    = malloc(((size_t)V + 1) * sizeof(int));
+    int *bucket = malloc((A ? A : 1) * sizeof(int));
+    if (!g->nbr || !g->nw || !g->eid || !pos || !bucket) { perror("malloc"); exit(1); }
+
+    memset(g->off, 0, ((size_t)V + 1) * sizeof(int));
+    for (int e = 0; e < E; ++e) { g->off[g->eu[e] + 1]++; g->off[g->ev[e] + 1]++; }
+    for (int i = 0; i < V; ++i) g->off[i + 1] += g->off[i];
+
+    /* pass 1: edge ids bucketed by source vertex */
+    memcpy(pos, g->off, ((size_t)V + 1) * sizeof(int));
+    for (int e = 0; e < E; ++e) {
+        bucket[pos[g->eu[e]]++] = e;
+        bucket[pos[g->ev[e]]++] = e;
+    }
+    /* pass 2: scatter into target rows, sources visited in ascending order */
+    memcpy(pos, g->off, ((size_t)V + 1) * sizeof(int));
+    for (int s = 0; s < V; ++s) {
+        for (int a = g->off[s]; a < g->off[s + 1]; ++a) {
+            int e = bucket[a];
+            int t = (g->eu[e] == s) ? g->ev[e] : g->eu[e];
+            int p = pos[t]++;
+            g->nbr[p] = s;
+            g->nw[p]  = g->ew[e];
+            g->eid[p] = e;
+        }
+    }
+    free(pos);
+    free(bucket);
+    g->csr_dirty = 0;
+}
+
+/* Aborts when a CSR graph is used before graph_finalize. */
+static void csr_require(const Graph *g) {
+    if (g->csr && g->csr_dirty) {
+        fprintf(stderr, "graph: CSR graph used before graph_finalize()\n");
+        exit(1);
+    }
+}
+
+static int csr_find(const Graph *g, int u, int v) {
+    int lo = g->off[u], hi = g->off[u + 1] - 1;
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (g->nbr[mid] == v) return mid;
+        if (g->nbr[mid] < v) lo = mid + 1; else hi = mid - 1;
+    }
+    return -1;
+}
+
+int graph_has_edge(const Graph *g, int u, int v) {
+    if (!g->csr) return adj_test(g, u, v);
+    csr_require(g);
+    return csr_find(g, u, v) >= 0;
+}
+
+int graph_weight(const Graph *g, int u, int v) {
+    if (!g->csr) return g->w[u][v];
+    csr_require(g);
+    int p = csr_find(g, u, v);
+    return p >= 0 ? g->nw[p] : 0;
+}
+
 int degree(const Graph *g, int u) {
-    int d = 0;
-    for (int v = 0; v < g->V; ++v) d += g->adj[u][v];
-    return d;
+    return g->deg[u];
 }
 
 void print_graph(const Graph *g) {
+    if (g->csr) {
+        csr_require(g);
+        printf("Graph: V=%d, E=%d\nAdjacency lists (v:w):\n", g->V, g->E);
+        for (int i = 0; i < g->V; ++i) {
+            printf("%d:", i);
+            for (int a = g->off[i]; a < g->off[i + 1]; ++a)
+                printf(" %d:%d", g->nbr[a], g->nw[a]);
+            printf("\n");
+        }
+        return;
+    }
     printf("Graph: V=%d, E=%d\nAdjacency matrix:\n", g->V, g->E);
     for (int i = 0; i < g->V; ++i) {
         for (int j = 0; j < g->V; ++j) {
-            printf("%d ", g->adj[i][j]);
+            printf("%d ", adj_test(g, i, j));
         }
         printf("\n");
     }
@@ -90,186 +375,682 @@ void print_graph(const Graph *g) {
 }
 
 
+/* SplitMix64 finaliser. rng_next() steps a caller-owned state word;
+   cb_rand(key, i) is the i-th output of the stream seeded with `key`, so
+   any position of any stream can be computed without the ones before it. */
+static inline uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+    return z ^ (z >> 31);
+}
+static inline uint64_t rng_next(uint64_t *state) {
+    return mix64(*state += UINT64_C(0x9e3779b97f4a7c15));
+}
+static inline uint64_t cb_rand(uint64_t key, uint64_t i) {
+    return mix64(key + (i + 1) * UINT64_C(0x9e3779b97f4a7c15));
+}
+/* Uniform double in (0, 1]. */
+static inline double rng_unit(uint64_t *state) {
+    return (double)((rng_next(state) >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+typedef struct { long long idx; uint64_t key; } Cand;
+
+static uint64_t select_kth_key(uint64_t *a, long long n, long long k) {
+    long long lo = 0, hi = n - 1;
+    while (lo < hi) {
+        uint64_t pivot = a[lo + (hi - lo) / 2];
+        long long i = lo, j = hi;
+        while (i <= j) {
+            while (a[i] < pivot) i++;
+            while (a[j] > pivot) j--;
+            if (i <= j) { uint64_t t = a[i]; a[i] = a[j]; a[j] = t; i++; j--; }
+        }
+        if (k <= j) hi = j;
+        else if (k >= i) lo = i;
+        else break;
+    }
+    return a[k];
+}
+
+/* One thread's share of the pair-index space: whole blocks [b0, b1).
+   Block b draws its geometric skips from its own stream, so the candidates
+   of a block do not depend on which thread produced them. */
+typedef struct {
+    long long N, b0, b1;
+    double p;
+    uint64_t skip_root, key_root;
+    Cand *c;
+    long long n, cap;
+} GenSlice;
+
+static void* gen_slice_main(void *arg) {
+    GenSlice *sl = (GenSlice*)arg;
+    const double lq = (sl->p < 1.0) ? log1p(-sl->p) : 0.0;
+    for (long long b = sl->b0; b < sl->b1; ++b) {
+        uint64_t st = cb_rand(sl->skip_root, (uint64_t)b);
+        long long end = (b + 1) * GRAPH_GEN_BLOCK;
+        if (end > sl->N) end = sl->N;
+        for (long long idx = b * GRAPH_GEN_BLOCK - 1;;) {
+            if (sl->p < 1.0) {
+                double skip = floor(log(rng_unit(&st)) / lq);
+                if (skip >= (double)(end - 1 - idx)) break;
+                idx += (long long)skip + 1;
+            } else if (++idx >= end) {
+                break;
+            }
+            if (sl->n == sl->cap) {
+                sl->cap = sl->cap ? sl->cap * 2 : 1024;
+                sl->c = realloc(sl->c, (size_t)sl->cap * sizeof(Cand));
+                if (!sl->c) { perror("realloc"); exit(1); }
+            }
+            sl->c[sl->n].idx = idx;
+            sl->c[sl->n].key = cb_rand(sl->key_root, (uint64_t)idx);
+            sl->n++;
+        }
+    }
+    return NULL;
+}
+
+/* Picks a uniform K-subset of [0, N) and returns it in ascending order.
+   Indices are first drawn as Bernoulli(p) candidates by geometric skipping,
+   each tagged with a key that depends only on (seed, index); p is set a few
+   standard deviations above K/N and raised on the rare shortfall. Keeping
+   the K smallest keys turns the candidates into an exact uniform K-subset
+   in O(K) expected time. Blocks of GRAPH_GEN_BLOCK indices are spread over
+   nthreads, and the result is the same for every thread count. */
+static long long* sample_indices(long long N, long long K, uint64_t root, int nthreads) {
+    long long *out = malloc((size_t)(K ? K : 1) * sizeof(long long));
+    if (!out) { perror("malloc"); exit(1); }
+    if (K == 0) return out;
+
+    const long long nblocks = (N + GRAPH_GEN_BLOCK - 1) / GRAPH_GEN_BLOCK;
+    if (nthreads < 1) nthreads = 1;
+    if (nthreads > nblocks) nthreads = (int)nblocks;
+    GenSlice *sl = calloc((size_t)nthreads, sizeof(GenSlice));
+    pthread_t *tid = malloc((size_t)nthreads * sizeof(pthread_t));
+    if (!sl || !tid) { perror("malloc"); exit(1); }
+
+    double slack = 4.0;
+    for (uint64_t attempt = 0;; ++attempt) {
+        double p = ((double)K + slack * sqrt((double)K) + 16.0) / (double)N;
+        long long total = 0;
+        for (int t = 0; t < nthreads; ++t) {
+            sl[t].N = N;
+            sl[t].b0 = nblocks * t / nthreads;
+            sl[t].b1 = nblocks * (t + 1) / nthreads;
+            sl[t].p = p;
+            sl[t].skip_root = cb_rand(root, 2 + attempt);
+            sl[t].key_root  = cb_rand(root, 0);
+            sl[t].n = 0;
+            if (t > 0 && pthread_create(&tid[t], NULL, gen_slice_main, &sl[t]) != 0) {
+                perror("pthread_create"); exit(1);
+            }
+        }
+        gen_slice_main(&sl[0]);
+        for (int t = 0; t < nthreads; ++t) {
+            if (t > 0) pthread_join(tid[t], NULL);
+            total += sl[t].n;
+        }
+
+        if (total >= K) {
+            uint64_t *keys = malloc((size_t)total * sizeof(uint64_t));
+            if (!keys) { perror("malloc"); exit(1); }
+            long long n = 0, below = 0, m = 0;
+            for (int t = 0; t < nthreads; ++t)
+                for (long long i = 0; i < sl[t].n; ++i) keys[n++] = sl[t].c[i].key;
+            uint64_t th = select_kth_key(keys, total, K - 1);
+            free(keys);
+            for (int t = 0; t < nthreads; ++t)
+                for (long long i = 0; i < sl[t].n; ++i) below += (sl[t].c[i].key < th);
+            long long ties = K - below;          /* keys equal to th, taken by index */
+            for (int t = 0; t < nthreads; ++t) {
+                for (long long i = 0; i < sl[t].n && m < K; ++i) {
+                    const Cand *c = &sl[t].c[i];
+                    if (c->key < th) out[m++] = c->idx;
+                    else if (c->key == th && ties > 0) { out[m++] = c->idx; ties--; }
+                }
+            }
+            break;
+        }
+        slack *= 2.0;
+    }
+    for (int t = 0; t < nthreads; ++t) free(sl[t].c);
+    free(sl);
+    free(tid);
+    return out;
+}
+
+/* Maps ascending upper-triangle indices k (row-major over u < v) to edges. */
+typedef struct { int V, u; long long row_start; } PairCursor;
+
+static void pair_at(PairCursor *pc, long long k, int *u, int *v) {
+    while (k >= pc->row_start + (pc->V - 1 - pc->u)) {
+        pc->row_start += pc->V - 1 - pc->u;
+        pc->u++;
+    }
+    *u = pc->u;
+    *v = pc->u + 1 + (int)(k - pc->row_start);
+}
+
+static void place_pair(Graph *g, PairCursor *pc, long long k, uint64_t wkey) {
+    int u, v;
+    pair_at(pc, k, &u, &v);
+    int w = (int)(cb_rand(wkey, (uint64_t)k) % GRAPH_RAND_WMAX) + 1;   // weight in [1..WMAX]
+    (void)add_edge_w(g, u, v, w);
+}
+
 void generate_random_graph(Graph *g, int targetE, unsigned int seed) {
-    srand(seed);
+    generate_random_graph_mt(g, targetE, seed, 1);
+}
+
+/* Deterministic for a given (V, targetE, seed) and independent of nthreads.
+   With root = mix64(seed), pair k of the N = V(V-1)/2 upper-triangle pairs
+   (row-major, u < v) gets selection key cb_rand(cb_rand(root,0), k) and
+   weight 1 + cb_rand(cb_rand(root,1), k) % GRAPH_RAND_WMAX; the chosen
+   pairs are those sample_indices() returns. When targetE > N/2 the
+   N - targetE absent pairs are sampled instead. Expects a graph without
+   edges; edges are inserted on the calling thread. */
+void generate_random_graph_mt(Graph *g, int targetE, unsigned int seed, int nthreads) {
     const long long maxE = (long long)g->V * (g->V - 1) / 2;
     if (targetE > maxE) {
         fprintf(stderr, "Error: cannot place %d edges in a simple graph with V=%d (max=%lld)\n",
                 targetE, g->V, maxE);
         exit(1);
     }
-    while (g->E < targetE) {
-        int u = rand() % g->V;
-        int v = rand() % g->V;
-        int w = (rand() % GRAPH_RAND_WMAX) + 1;   // weight in [1..WMAX]
-        (void)add_edge_w(g, u, v, w);
+    const uint64_t root = mix64((uint64_t)seed);
+    const uint64_t wkey = cb_rand(root, 1);
+    const int dense = (long long)targetE > maxE / 2;
+    const long long K = dense ? maxE - targetE : targetE;
+    long long *pick = sample_indices(maxE, K, root, nthreads);
+
+    PairCursor pc = { g->V, 0, 0 };
+    if (!dense) {
+        for (long long i = 0; i < K; ++i) place_pair(g, &pc, pick[i], wkey);
+    } else {
+        for (long long k = 0, i = 0; k < maxE; ++k) {
+            if (i < K && pick[i] == k) { i++; continue; }
+            place_pair(g, &pc, k, wkey);
+        }
     }
+    free(pick);
+    graph_finalize(g);
 }
 
 
-static void dfs(const Graph *g, int u, int *visited) {
-    visited[u] = 1;
-    for (int v = 0; v < g->V; ++v) {
-        if (g->adj[u][v] && !visited[v]) dfs(g, v, visited);
-    }
-}
-
+/* Isolated vertices are singleton components, so the non-isolated ones
+   are connected exactly when they add up to one more component. */
 int connected_among_non_isolated(const Graph *g) {
-    int start = -1;
-    for (int i = 0; i < g->V; ++i) if (degree(g, i) > 0) { start = i; break; }
-    if (start == -1) return 1; // no edges: treat as Eulerian-trivial
-    int *visited = calloc(g->V, sizeof(int));
-    if (!visited) { perror("calloc"); exit(1); }
-    dfs(g, start, visited);
-    int ok = 1;
-    for (int i = 0; i < g->V; ++i) {
-        if (degree(g, i) > 0 && !visited[i]) { ok = 0; break; }
-    }
-    free(visited);
-    return ok;
+    if (g->E == 0) return 1; // no edges: treat as Eulerian-trivial
+    return g->ncomp - g->isolated == 1;
 }
 
 
 int all_even_degrees(const Graph *g) {
-    for (int i = 0; i < g->V; ++i)
-        if (degree(g, i) % 2 != 0) return 0;
-    return 1;
+    return g->odd == 0;
+}
+
+/* Hierholzer over incidence rows (off, nbr, eid): each vertex keeps a
+   cursor into its row, which is sorted by neighbour id, and a bitmap marks
+   edges consumed from the other endpoint. Every edge is passed over at most
+   twice, so the walk is O(V + E), and it still follows the "smallest unused
+   neighbour" order of the original matrix scan, giving identical circuits. */
+static int* euler_walk(int V, int E, const int *off, const int *nbr, const int *eid,
+                       int start, int *len_out) {
+    int *cur = malloc(((size_t)V + 1) * sizeof(int));
+    uint64_t *used = calloc(((size_t)E + 64) / 64, sizeof(uint64_t));
+    int *stack = malloc(((size_t)E + 2) * sizeof(int));
+    int *out   = malloc(((size_t)E + 2) * sizeof(int));
+    if (!cur || !used || !stack || !out) { perror("malloc"); exit(1); }
+    memcpy(cur, off, (size_t)V * sizeof(int));
+
+    int top = 0, outLen = 0;
+    stack[top++] = start;
+    while (top > 0) {
+        int u = stack[top - 1];
+        int c = cur[u], end = off[u + 1];
+        while (c < end && ((used[eid[c] >> 6] >> (eid[c] & 63)) & 1U)) c++;
+        if (c < end) {
+            used[eid[c] >> 6] |= UINT64_C(1) << (eid[c] & 63);
+            stack[top++] = nbr[c];
+            c++;
+        } else {
+            out[outLen++] = u;
+            top--;
+        }
+        cur[u] = c;
+    }
+    free(cur);
+    free(used);
+    free(stack);
+
+    *len_out = outLen;
+    return out;
 }
 
 int euler_circuit(const Graph *g, int **path_out, int *path_len_out) {
+    csr_require(g);
     if (!connected_among_non_isolated(g)) return 0;
     if (!all_even_degrees(g)) return 0;
 
-    int **adj = malloc(g->V * sizeof(int*));
-    if (!adj) { perror("malloc"); exit(1); }
-    for (int i = 0; i < g->V; ++i) {
-        adj[i] = malloc(g->V * sizeof(int));
-        if (!adj[i]) { perror("malloc"); exit(1); }
-        memcpy(adj[i], g->adj[i], g->V * sizeof(int));
+    int start = 0;
+    for (int i = 0; i < g->V; ++i) if (degree(g, i) > 0) { start = i; break; }
+
+    if (g->csr) {
+        *path_out = euler_walk(g->V, g->E, g->off, g->nbr, g->eid, start, path_len_out);
+        return 1;
     }
-    int *deg = malloc(g->V * sizeof(int));
-    if (!deg) { perror("malloc"); exit(1); }
-    for (int i = 0; i < g->V; ++i) deg[i] = degree(g, i);
 
-    int start = 0;
-    for (int i = 0; i < g->V; ++i) if (deg[i] > 0) { start = i; break; }
+    /* Dense graph: one row-major pass builds sorted incidence rows with
+       edge ids assigned to the upper triangle; no matrix copy is made. */
+    const int V = g->V;
+    int *off = calloc((size_t)V + 1, sizeof(int));
+    int *nbr = malloc(((size_t)2 * g->E + 1) * sizeof(int));
+    int *eid = malloc(((size_t)2 * g->E + 1) * sizeof(int));
+    int *pos = malloc((size_t)V * sizeof(int));
+    if (!off || !nbr || !eid || !pos) { perror("malloc"); exit(1); }
+    for (int i = 0; i < V; ++i) off[i + 1] = off[i] + degree(g, i);
+
+    memcpy(pos, off, (size_t)V * sizeof(int));
+    int next = 0;
+    const int nw = (V + 63) / 64;
+    for (int u = 0; u < V; ++u) {
+        const uint64_t *row = adj_row(g, u);
+        for (int k = 0; k < nw; ++k) for (uint64_t m = row[k]; m; m &= m - 1) {
+            int v = (k << 6) + __builtin_ctzll(m);
+            int p = pos[u]++;
+            nbr[p] = v;
+            if (v > u) eid[p] = next++;
+            else       eid[p] = -1;
+        }
+    }
+    /* Lower-triangle entries lead each sorted row; visiting u in ascending
+       order fills them front to back with the id of the mirrored (u,v). */
+    memcpy(pos, off, (size_t)V * sizeof(int));
+    for (int u = 0; u < V; ++u)
+        for (int p = off[u]; p < off[u + 1]; ++p)
+            if (nbr[p] > u) eid[pos[nbr[p]]++] = eid[p];
+    free(pos);
+
+    *path_out = euler_walk(V, g->E, off, nbr, eid, start, path_len_out);
+    free(off);
+    free(nbr);
+    free(eid);
+    return 1;
+}
 
-    int stackCap = g->E + 2, top = 0;
-    int *stack = malloc(stackCap * sizeof(int));
-    if (!stack) { perror("malloc"); exit(1); }
 
-    int outCap = g->E + 2, outLen = 0;
-    int *out = malloc(outCap * sizeof(int));
-    if (!out) { perror("malloc"); exit(1); }
+typedef struct { int key, v; } HeapItem;
 
-    stack[top++] = start;
-    while (top > 0) {
-        int u = stack[top - 1], v = -1;
-        if (deg[u] > 0) {
-            for (int w = 0; w < g->V; ++w) if (adj[u][w]) { v = w; break; }
-        }
-        if (v != -1) {
-            adj[u][v]--; adj[v][u]--;
-            deg[u]--; deg[v]--;
-            if (top >= stackCap) {
-                stackCap *= 2;
-                stack = realloc(stack, stackCap * sizeof(int));
-                if (!stack) { perror("realloc"); exit(1); }
-            }
-            stack[top++] = v;
-        } else {
-            if (outLen >= outCap) {
-                outCap *= 2;
-                out = realloc(out, outCap * sizeof(int));
-                if (!out) { perror("realloc"); exit(1); }
+static void heap_push(HeapItem *h, int *n, HeapItem it) {
+    int i = (*n)++;
+    while (i > 0) {
+        int p = (i - 1) / 2;
+        if (h[p].key <= it.key) break;
+        h[i] = h[p]; i = p;
+    }
+    h[i] = it;
+}
+static HeapItem heap_pop(HeapItem *h, int *n) {
+    HeapItem top = h[0], last = h[--(*n)];
+    int i = 0;
+    for (;;) {
+        int c = 2 * i + 1;
+        if (c >= *n) break;
+        if (c + 1 < *n && h[c + 1].key < h[c].key) c++;
+        if (last.key <= h[c].key) break;
+        h[i] = h[c]; i = c;
+    }
+    h[i] = last;
+    return top;
+}
+
+/* Lazy-deletion binary-heap Prim over CSR rows, O(E log V). A vertex left
+   unreached when the heap drains means the graph is disconnected. */
+static long long mst_weight_prim_csr(const Graph *g) {
+    const int V = g->V;
+    const int INF = INT_MAX / 4;
+    int *key = malloc((size_t)V * sizeof(int));
+    unsigned char *inMST = calloc((size_t)V, 1);
+    HeapItem *heap = malloc(((size_t)2 * g->E + 1) * sizeof(HeapItem));
+    if (!key || !inMST || !heap) { perror("malloc"); exit(1); }
+    for (int i = 0; i < V; ++i) key[i] = INF;
+
+    int n = 0, reached = 0;
+    long long total = 0;
+    key[0] = 0;
+    heap_push(heap, &n, (HeapItem){0, 0});
+    while (n > 0) {
+        HeapItem it = heap_pop(heap, &n);
+        int u = it.v;
+        if (inMST[u] || it.key != key[u]) continue;
+        inMST[u] = 1;
+        reached++;
+        total += it.key;
+        for (int a = g->off[u]; a < g->off[u + 1]; ++a) {
+            int v = g->nbr[a];
+            if (!inMST[v] && g->nw[a] < key[v]) {
+                key[v] = g->nw[a];
+                heap_push(heap, &n, (HeapItem){key[v], v});
             }
-            out[outLen++] = u;
-            top--;
         }
     }
+    free(key);
+    free(inMST);
+    free(heap);
+    return reached == V ? total : -1;
+}
+
+/* Dense Prim kernels. Keys are stored as (key - 1) in uint32, so a missing
+   edge (weight 0) becomes UINT32_MAX, and vertices already in the tree have
+   dead[v] = ~0 so that OR-ing it in makes their candidate UINT32_MAX too.
+   Relaxation is then a branchless unsigned min and the argmin needs no
+   membership test. Arrays and weight rows are padded to 16 entries with
+   UINT32_MAX / ~0 / 0 respectively, so kernels never need a scalar tail. */
+typedef struct {
+    uint32_t (*min)(const uint32_t *key, int n);
+    int      (*find)(const uint32_t *key, int n, uint32_t val);
+    void     (*relax)(uint32_t *key, const uint32_t *dead, const int *wrow, int n);
+} PrimKernels;
+
+static uint32_t prim_min_scalar(const uint32_t *key, int n) {
+    uint32_t m = UINT32_MAX;
+    for (int i = 0; i < n; ++i) m = key[i] < m ? key[i] : m;
+    return m;
+}
+static int prim_find_scalar(const uint32_t *key, int n, uint32_t val) {
+    for (int i = 0; i < n; ++i) if (key[i] == val) return i;
+    return -1;
+}
+static void prim_relax_scalar(uint32_t *key, const uint32_t *dead, const int *wrow, int n) {
+    for (int i = 0; i < n; ++i) {
+        uint32_t c = ((uint32_t)wrow[i] - 1u) | dead[i];
+        key[i] = c < key[i] ? c : key[i];
+    }
+}
 
-    for (int i = 0; i < g->V; ++i) free(adj[i]);
-    free(adj);
-    free(deg);
-    free(stack);
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static uint32_t prim_min_avx2(const uint32_t *key, int n) {
+    __m256i m = _mm256_set1_epi32(-1);
+    for (int i = 0; i < n; i += 8)
+        m = _mm256_min_epu32(m, _mm256_load_si256((const __m256i*)(key + i)));
+    __m128i h = _mm_min_epu32(_mm256_castsi256_si128(m), _mm256_extracti128_si256(m, 1));
+    h = _mm_min_epu32(h, _mm_shuffle_epi32(h, _MM_SHUFFLE(1, 0, 3, 2)));
+    h = _mm_min_epu32(h, _mm_shuffle_epi32(h, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (uint32_t)_mm_cvtsi128_si32(h);
+}
+__attribute__((target("avx2")))
+static int prim_find_avx2(const uint32_t *key, int n, uint32_t val) {
+    const __m256i v = _mm256_set1_epi32((int)val);
+    for (int i = 0; i < n; i += 8) {
+        __m256i eq = _mm256_cmpeq_epi32(_mm256_load_si256((const __m256i*)(key + i)), v);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+        if (mask) return i + __builtin_ctz((unsigned)mask);
+    }
+    return -1;
+}
+__attribute__((target("avx2")))
+static void prim_relax_avx2(uint32_t *key, const uint32_t *dead, const int *wrow, int n) {
+    const __m256i one = _mm256_set1_epi32(1);
+    for (int i = 0; i < n; i += 8) {
+        __m256i w = _mm256_load_si256((const __m256i*)(wrow + i));
+        __m256i c = _mm256_or_si256(_mm256_sub_epi32(w, one),
+                                    _mm256_load_si256((const __m256i*)(dead + i)));
+        __m256i k = _mm256_load_si256((const __m256i*)(key + i));
+        _mm256_store_si256((__m256i*)(key + i), _mm256_min_epu32(k, c));
+    }
+}
 
-    *path_out = out;
-    *path_len_out = outLen;
-    return 1;
+__attribute__((target("avx512f")))
+static uint32_t prim_min_avx512(const uint32_t *key, int n) {
+    __m512i m = _mm512_set1_epi32(-1);
+    for (int i = 0; i < n; i += 16)
+        m = _mm512_min_epu32(m, _mm512_load_si512((const void*)(key + i)));
+    return (uint32_t)_mm512_reduce_min_epu32(m);
+}
+__attribute__((target("avx512f")))
+static int prim_find_avx512(const uint32_t *key, int n, uint32_t val) {
+    const __m512i v = _mm512_set1_epi32((int)val);
+    for (int i = 0; i < n; i += 16) {
+        __mmask16 mask = _mm512_cmpeq_epu32_mask(_mm512_load_si512((const void*)(key + i)), v);
+        if (mask) return i + __builtin_ctz((unsigned)mask);
+    }
+    return -1;
+}
+__attribute__((target("avx512f")))
+static void prim_relax_avx512(uint32_t *key, const uint32_t *dead, const int *wrow, int n) {
+    const __m512i one = _mm512_set1_epi32(1);
+    for (int i = 0; i < n; i += 16) {
+        __m512i w = _mm512_load_si512((const void*)(wrow + i));
+        __m512i c = _mm512_or_si512(_mm512_sub_epi32(w, one),
+                                    _mm512_load_si512((const void*)(dead + i)));
+        __m512i k = _mm512_load_si512((const void*)(key + i));
+        _mm512_store_si512((void*)(key + i), _mm512_min_epu32(k, c));
+    }
 }
+#endif
 
+static PrimKernels prim_kernels;
+static pthread_once_t prim_kernels_once = PTHREAD_ONCE_INIT;
+
+static void prim_kernels_pick(void) {
+    prim_kernels = (PrimKernels){ prim_min_scalar, prim_find_scalar, prim_relax_scalar };
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        prim_kernels = (PrimKernels){ prim_min_avx512, prim_find_avx512, prim_relax_avx512 };
+    else if (__builtin_cpu_supports("avx2"))
+        prim_kernels = (PrimKernels){ prim_min_avx2, prim_find_avx2, prim_relax_avx2 };
+#endif
+}
 
 long long mst_weight_prim(const Graph *g) {
     const int V = g->V;
-    if (V == 0) return 0;
-    if (V == 1) return 0;
-
-    for (int i = 0; i < V; ++i) {
-        if (degree(g, i) == 0) return -1;  
+    if (V <= 1) return 0;
+    csr_require(g);
+    if (g->ncomp > 1) return -1;
+    if (g->csr) return mst_weight_prim_csr(g);
+
+    pthread_once(&prim_kernels_once, prim_kernels_pick);
+    const PrimKernels K = prim_kernels;
+    const int n = g->wstride;                       /* V padded to 16 */
+    uint32_t *key = NULL, *dead = NULL;
+    if (posix_memalign((void**)&key,  GRAPH_CACHELINE, (size_t)n * sizeof(uint32_t)) != 0 ||
+        posix_memalign((void**)&dead, GRAPH_CACHELINE, (size_t)n * sizeof(uint32_t)) != 0) {
+        perror("posix_memalign"); exit(1);
     }
-   
-    int *vis = calloc(V, sizeof(int));
-    if (!vis) { perror("calloc"); exit(1); }
-    
-    int stackSize = V, top = 0;
-    int *stack = malloc(stackSize * sizeof(int));
-    if (!stack) { perror("malloc"); exit(1); }
-    stack[top++] = 0; vis[0] = 1;
-    while (top) {
-        int u = stack[--top];
-        for (int v = 0; v < V; ++v) {
-            if (g->adj[u][v] && !vis[v]) {
-                vis[v] = 1;
-                if (top >= stackSize) {
-                    stackSize *= 2;
-                    stack = realloc(stack, stackSize * sizeof(int));
-                    if (!stack) { perror("realloc"); exit(1); }
-                }
-                stack[top++] = v;
-            }
+    for (int i = 0; i < n; ++i) { key[i] = UINT32_MAX; dead[i] = (i < V) ? 0 : UINT32_MAX; }
+
+    long long total = 0;
+    int u = 0;
+    for (int it = 0; it < V; ++it) {
+        if (it > 0) {
+            uint32_t best = K.min(key, n);
+            if (best == UINT32_MAX) { free(key); free(dead); return -1; }
+            u = K.find(key, n, best);
+            total += (long long)best + 1;
         }
+        dead[u] = UINT32_MAX;
+        key[u]  = UINT32_MAX;
+        K.relax(key, dead, g->w[u], n);
     }
-    for (int i = 0; i < V; ++i) {
-        if (!vis[i]) { free(vis); free(stack); return -1; }
-    }
-    free(vis);
-    free(stack);
 
-    const int INF = INT_MAX / 4;
-    int *key    = malloc(V * sizeof(int));
-    int *inMST  = calloc(V, sizeof(int));
-    if (!key || !inMST) { perror("malloc"); exit(1); }
+    free(key);
+    free(dead);
+    return total;
+}
 
-    for (int i = 0; i < V; ++i) key[i] = INF;
-    key[0] = 0;
 
-    long long total = 0;
+/* Edge list in storage order: CSR graphs lend their own arrays, dense
+   graphs are scanned once row by row over the upper triangle. */
+typedef struct { const int *u, *v, *w; int n; int *buf; } EdgeList;
 
-    for (int it = 0; it < V; ++it) {
-        int u = -1, best = INF;
-        for (int i = 0; i < V; ++i) {
-            if (!inMST[i] && key[i] < best) {
-                best = key[i]; u = i;
+static EdgeList edge_list(const Graph *g) {
+    EdgeList el = { NULL, NULL, NULL, g->E, NULL };
+    if (g->csr) {
+        el.u = g->eu; el.v = g->ev; el.w = g->ew;
+        return el;
+    }
+    el.buf = malloc(3 * ((size_t)g->E + 1) * sizeof(int));
+    if (!el.buf) { perror("malloc"); exit(1); }
+    int *eu = el.buf, *ev = eu + g->E + 1, *ew = ev + g->E + 1, n = 0;
+    const int nw = (g->V + 63) / 64;
+    for (int u = 0; u < g->V; ++u) {
+        const uint64_t *row = adj_row(g, u);
+        for (int k = (u + 1) >> 6; k < nw; ++k) {
+            uint64_t m = row[k];
+            if (k == (u + 1) >> 6) m &= ~UINT64_C(0) << ((u + 1) & 63);
+            for (; m; m &= m - 1) {
+                int v = (k << 6) + __builtin_ctzll(m);
+                eu[n] = u; ev[n] = v; ew[n] = g->w[u][v]; n++;
             }
         }
-        if (u == -1 || best == INF) {  
-            free(key); free(inMST);
-            return -1;
+    }
+    el.u = eu; el.v = ev; el.w = ew;
+    return el;
+}
+
+/* Stable LSD radix sort of edge ids by weight, one pass per byte that
+   actually varies (a single pass for the default 1..100 weights). */
+static int* edges_by_weight(const EdgeList *el) {
+    const int n = el->n;
+    int *ord = malloc(((size_t)n + 1) * sizeof(int));
+    int *tmp = malloc(((size_t)n + 1) * sizeof(int));
+    if (!ord || !tmp) { perror("malloc"); exit(1); }
+    unsigned orw = 0, andw = ~0u;
+    for (int i = 0; i < n; ++i) { ord[i] = i; orw |= (unsigned)el->w[i]; andw &= (unsigned)el->w[i]; }
+    for (int shift = 0; shift < 32; shift += 8) {
+        if ((((orw ^ andw) >> shift) & 0xFFu) == 0) continue;   /* byte is constant */
+        size_t cnt[257] = {0};
+        for (int i = 0; i < n; ++i) cnt[(((unsigned)el->w[i] >> shift) & 0xFFu) + 1]++;
+        for (int b = 0; b < 256; ++b) cnt[b + 1] += cnt[b];
+        for (int i = 0; i < n; ++i) {
+            int e = ord[i];
+            tmp[cnt[((unsigned)el->w[e] >> shift) & 0xFFu]++] = e;
         }
-        inMST[u] = 1;
-        total += (it == 0 ? 0 : best);
+        int *t = ord; ord = tmp; tmp = t;
+    }
+    free(tmp);
+    return ord;
+}
 
-        for (int v = 0; v < V; ++v) {
-            if (!inMST[v] && g->adj[u][v]) {
-                int w = g->w[u][v];
-                if (w < key[v]) key[v] = w;
+long long mst_weight_kruskal(const Graph *g, int *components_out) {
+    const int V = g->V;
+    csr_require(g);
+    EdgeList el = edge_list(g);
+    int *ord = edges_by_weight(&el);
+    int *uf = malloc(2 * ((size_t)V + 1) * sizeof(int)), *sz = uf + V + 1;
+    if (!uf) { perror("malloc"); exit(1); }
+    for (int i = 0; i < V; ++i) { uf[i] = i; sz[i] = 1; }
+
+    long long total = 0;
+    int comps = V;
+    for (int i = 0; i < el.n && comps > 1; ++i) {
+        int e = ord[i];
+        int a = uf_find(uf, el.u[e]), b = uf_find(uf, el.v[e]);
+        if (a == b) continue;
+        if (sz[a] < sz[b]) { int t = a; a = b; b = t; }
+        uf[b] = a; sz[a] += sz[b];
+        total += el.w[e];
+        comps--;
+    }
+    free(uf);
+    free(ord);
+    free(el.buf);
+    if (components_out) *components_out = comps;
+    return comps > 1 ? -1 : total;
+}
+
+/* Borůvka round state. During the scan phase comp[] is flat (every entry is
+   a root) and read-only, so workers only contend on best[], which holds
+   (weight << 32 | edge id) and is lowered with an atomic min. Ordering by
+   edge id on equal weights keeps the chosen edges cycle-free. */
+typedef struct {
+    const EdgeList *el;
+    const int *comp;
+    uint64_t *best;
+    int e0, e1;
+} BoruvkaSlice;
+
+static void atomic_min_u64(uint64_t *p, uint64_t val) {
+    uint64_t cur = __atomic_load_n(p, __ATOMIC_RELAXED);
+    while (val < cur &&
+           !__atomic_compare_exchange_n(p, &cur, val, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+}
+
+static void* boruvka_scan(void *arg) {
+    BoruvkaSlice *sl = (BoruvkaSlice*)arg;
+    for (int e = sl->e0; e < sl->e1; ++e) {
+        int a = sl->comp[sl->el->u[e]], b = sl->comp[sl->el->v[e]];
+        if (a == b) continue;
+        uint64_t key = ((uint64_t)(uint32_t)sl->el->w[e] << 32) | (uint32_t)e;
+        atomic_min_u64(&sl->best[a], key);
+        atomic_min_u64(&sl->best[b], key);
+    }
+    return NULL;
+}
+
+long long mst_weight_boruvka(const Graph *g, int nthreads, int *components_out) {
+    const int V = g->V;
+    csr_require(g);
+    EdgeList el = edge_list(g);
+    if (nthreads < 1) nthreads = 1;
+    if (nthreads > el.n / 4096 + 1) nthreads = el.n / 4096 + 1;
+
+    int *comp = malloc(((size_t)V + 1) * sizeof(int));
+    uint64_t *best = malloc(((size_t)V + 1) * sizeof(uint64_t));
+    BoruvkaSlice *sl = malloc((size_t)nthreads * sizeof(BoruvkaSlice));
+    pthread_t *tid = malloc((size_t)nthreads * sizeof(pthread_t));
+    if (!comp || !best || !sl || !tid) { perror("malloc"); exit(1); }
+    for (int i = 0; i < V; ++i) comp[i] = i;
+
+    long long total = 0;
+    int comps = V;
+    for (;;) {
+        for (int i = 0; i < V; ++i) best[i] = UINT64_MAX;
+        for (int t = 0; t < nthreads; ++t) {
+            sl[t] = (BoruvkaSlice){ &el, comp, best,
+                                    (int)((long long)el.n * t / nthreads),
+                                    (int)((long long)el.n * (t + 1) / nthreads) };
+            if (t > 0 && pthread_create(&tid[t], NULL, boruvka_scan, &sl[t]) != 0) {
+                perror("pthread_create"); exit(1);
             }
         }
+        boruvka_scan(&sl[0]);
+        for (int t = 1; t < nthreads; ++t) pthread_join(tid[t], NULL);
+
+        int merged = 0;
+        for (int r = 0; r < V; ++r) {
+            if (best[r] == UINT64_MAX) continue;    /* only round roots have one */
+            int e = (int)(uint32_t)best[r];
+            int a = uf_find(comp, el.u[e]), b = uf_find(comp, el.v[e]);
+            if (a == b) continue;                /* picked from both sides */
+            comp[b] = a;
+            total += el.w[e];
+            merged++;
+        }
+        if (!merged) break;
+        comps -= merged;
+        for (int i = 0; i < V; ++i) comp[i] = uf_find(comp, i);
     }
+    free(comp);
+    free(best);
+    free(sl);
+    free(tid);
+    free(el.buf);
+    if (components_out) *components_out = comps;
+    return comps > 1 ? -1 : total;
+}
 
-    free(key);
-    free(inMST);
-    return total;
+long long mst_weight(const Graph *g, int nthreads, int *components_out) {
+    if (components_out) *components_out = g->ncomp;
+    if (g->V <= 1) return 0;
+    if (!g->csr && (double)g->E * GRAPH_MST_PRIM_RATIO >= (double)g->V * g->V)
+        return mst_weight_prim(g);
+    if (nthreads > 1 && g->E >= GRAPH_MST_PAR_MIN_EDGES)
+        return mst_weight_boruvka(g, nthreads, components_out);
+    return mst_weight_kruskal(g, components_out);
 }
 
 
@@ -320,69 +1101,109 @@ static inline void bs_clear(Bitset *b, int i){
 typedef struct {
     int V;
     Bitset *N;          
+    int owned;          /* rows allocated here (CSR) rather than viewing g->bits */
 } NBMasks;
 
 static NBMasks nb_build(const Graph *g){
     NBMasks nb; nb.V = g->V;
     nb.N = malloc((size_t)g->V * sizeof(Bitset));
     if (!nb.N) { perror("malloc"); exit(1); }
+    nb.owned = g->csr;
     for (int v=0; v<g->V; ++v){
+        if (!g->csr) {
+            /* dense graphs already hold packed rows: view them in place */
+            nb.N[v].nbits = g->V;
+            nb.N[v].nwords = (g->V + 63) / 64;
+            nb.N[v].w = adj_row(g, v);
+            continue;
+        }
         nb.N[v] = bs_make(g->V);
-        for (int u=0; u<g->V; ++u) if (g->adj[v][u]) bs_set(&nb.N[v], u);
+        for (int a=g->off[v]; a<g->off[v+1]; ++a) bs_set(&nb.N[v], g->nbr[a]);
     }
     return nb;
 }
 static void nb_free(NBMasks *nb){
     if (!nb->N) return;
-    for (int v=0; v<nb->V; ++v) bs_free(&nb->N[v]);
+    if (nb->owned) for (int v=0; v<nb->V; ++v) bs_free(&nb->N[v]);
     free(nb->N); nb->N=NULL;
 }
 
-static int choose_pivot(const Bitset *P, const Bitset *X, const NBMasks *nb){
-    Bitset U = bs_make(P->nbits);
-    bs_copy(&U, P); bs_or(&U, X);
+static inline Bitset bs_view(uint64_t *w, int nbits){
+    Bitset b; b.nbits = nbits; b.nwords = (nbits + 63) / 64; b.w = w; return b;
+}
+/* dst = a & b without a temporary copy. */
+static inline void bs_and_into(Bitset *dst, const Bitset *a, const Bitset *b){
+    for (int k=0;k<dst->nwords;k++) dst->w[k] = a->w[k] & b->w[k];
+}
+static inline int bs_and_count(const Bitset *a, const Bitset *b){
+    int s=0; for(int k=0;k<a->nwords;k++) s += __builtin_popcountll(a->w[k] & b->w[k]); return s;
+}
 
+/* Scratch for the clique engines: `per` bitsets for every recursion depth,
+   carved from one slab allocated up front. A clique has at most
+   maxdeg + 1 vertices, so maxdeg + 2 levels (plus one spare) cover the
+   deepest call. */
+typedef struct {
+    int nbits, nwords, per;
+    uint64_t *slab;
+} BKScratch;
+
+static BKScratch bk_scratch_make(const Graph *g, int per){
+    int maxdeg = 0;
+    for (int v=0; v<g->V; ++v) if (g->deg[v] > maxdeg) maxdeg = g->deg[v];
+    BKScratch sc;
+    sc.nbits = g->V;
+    sc.nwords = (g->V + 63) / 64;
+    sc.per = per;
+    sc.slab = calloc((size_t)(maxdeg + 3) * per * sc.nwords + 1, sizeof(uint64_t));
+    if (!sc.slab) { perror("calloc"); exit(1); }
+    return sc;
+}
+static inline Bitset bk_slot(const BKScratch *sc, int depth, int i){
+    return bs_view(sc->slab + ((size_t)depth * sc->per + i) * sc->nwords, sc->nbits);
+}
+
+static int choose_pivot(const Bitset *P, const Bitset *X, const NBMasks *nb){
     int best_u = -1, best_deg = -1;
-    for (int word=0; word<U.nwords; ++word){
-        uint64_t w = U.w[word];
+    for (int word=0; word<P->nwords; ++word){
+        uint64_t w = P->w[word] | X->w[word];
         while (w){
             int bit = __builtin_ctzll(w);
             int u = (word<<6) + bit;
-            if (u >= U.nbits) break;
-            Bitset tmp = bs_make(P->nbits);
-            bs_copy(&tmp, P);
-            bs_and(&tmp, &nb->N[u]);
-            int deg = bs_count(&tmp);
-            bs_free(&tmp);
+            if (u >= P->nbits) break;
+            int deg = bs_and_count(P, &nb->N[u]);
             if (deg > best_deg){ best_deg = deg; best_u = u; }
             w &= (w-1);
         }
     }
-    bs_free(&U);
     return best_u;     
 }
 
 typedef struct {
     int best_size;
-    Bitset best_R;
+    int *best_R;
+    int *R;             /* current clique, one vertex per depth */
     const NBMasks *nb;
+    BKScratch sc;       /* per depth: P, X, P \ N(pivot) */
 } BKState;
 
-static void BK_recurse(Bitset *R, Bitset *P, Bitset *X, BKState *S){
-    if (bs_empty(P) && bs_empty(X)){
-        int sz = bs_count(R);
-        if (sz > S->best_size){
-            S->best_size = sz;
-            bs_copy(&S->best_R, R);
+/* P and X of depth d live in slots 0 and 1 of level d. */
+static void BK_recurse(int depth, BKState *S){
+    Bitset P = bk_slot(&S->sc, depth, 0), X = bk_slot(&S->sc, depth, 1);
+    if (bs_empty(&P) && bs_empty(&X)){
+        if (depth > S->best_size){
+            S->best_size = depth;
+            memcpy(S->best_R, S->R, (size_t)depth * sizeof(int));
         }
         return;
     }
 
-    int u = choose_pivot(P, X, S->nb);        
-    Bitset P_without_Nu = bs_make(P->nbits);
-    bs_copy(&P_without_Nu, P);
+    int u = choose_pivot(&P, &X, S->nb);        
+    Bitset P_without_Nu = bk_slot(&S->sc, depth, 2);
+    bs_copy(&P_without_Nu, &P);
     if (u >= 0) bs_minus(&P_without_Nu, &S->nb->N[u]);
 
+    Bitset Pp = bk_slot(&S->sc, depth + 1, 0), Xp = bk_slot(&S->sc, depth + 1, 1);
     for (int word=0; word<P_without_Nu.nwords; ++word){
         uint64_t w = P_without_Nu.w[word];
         while (w){
@@ -390,172 +1211,2476 @@ static void BK_recurse(Bitset *R, Bitset *P, Bitset *X, BKState *S){
             int v = (word<<6) + bit;
             if (v >= P_without_Nu.nbits) break;
 
-            Bitset Rp = bs_make(R->nbits); bs_copy(&Rp, R); bs_set(&Rp, v);
-
-            Bitset Pp = bs_make(P->nbits); bs_copy(&Pp, P); bs_and(&Pp, &S->nb->N[v]);
-            Bitset Xp = bs_make(X->nbits); bs_copy(&Xp, X); bs_and(&Xp, &S->nb->N[v]);
+            S->R[depth] = v;
+            bs_and_into(&Pp, &P, &S->nb->N[v]);
+            bs_and_into(&Xp, &X, &S->nb->N[v]);
 
-            BK_recurse(&Rp, &Pp, &Xp, S);
+            BK_recurse(depth + 1, S);
 
-            Bitset singleton = bs_make(P->nbits); bs_set(&singleton, v);
-            bs_minus(P, &singleton);
-            bs_or(X, &singleton);
-            bs_free(&singleton);
-
-            bs_free(&Rp); bs_free(&Pp); bs_free(&Xp);
+            bs_clear(&P, v);
+            bs_set(&X, v);
 
             w &= (w-1); 
         }
     }
-    bs_free(&P_without_Nu);
 }
 
-int max_clique(const Graph *g, int *clique_out, int *clique_size_out){
+static int cmp_int(const void *a, const void *b){
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+static int bk_max_clique(const Graph *g, int nthreads, int *clique_out, int *clique_size_out){
+    (void)nthreads;
     const int V = g->V;
+    csr_require(g);
     NBMasks nb = nb_build(g);
 
-    Bitset R = bs_make(V), P = bs_make(V), X = bs_make(V);
-    for (int v=0; v<V; ++v) bs_set(&P, v);
-
     BKState S;
     S.best_size = 0;
-    S.best_R = bs_make(V);
+    S.best_R = malloc(((size_t)V + 1) * sizeof(int));
+    S.R = malloc(((size_t)V + 1) * sizeof(int));
+    if (!S.best_R || !S.R) { perror("malloc"); exit(1); }
     S.nb = &nb;
+    S.sc = bk_scratch_make(g, 3);
 
-    BK_recurse(&R, &P, &X, &S);
+    Bitset P = bk_slot(&S.sc, 0, 0);
+    for (int v=0; v<V; ++v) bs_set(&P, v);
+
+    BK_recurse(0, &S);
 
+    /* report in ascending vertex order, as the bitset walk used to */
+    qsort(S.best_R, (size_t)S.best_size, sizeof(int), cmp_int);
     if (clique_out){
-        int k = 0;
-        for (int word=0; word<S.best_R.nwords; ++word){
-            uint64_t w = S.best_R.w[word];
-            while (w){
-                int bit = __builtin_ctzll(w);
-                int v = (word<<6) + bit;
-                if (v < V) clique_out[k++] = v;
-                w &= (w-1);
-            }
-        }
+        memcpy(clique_out, S.best_R, (size_t)S.best_size * sizeof(int));
         if (clique_size_out) *clique_size_out = S.best_size;
     } else if (clique_size_out){
         *clique_size_out = S.best_size;
     }
 
-    bs_free(&R); bs_free(&P); bs_free(&X);
-    bs_free(&S.best_R);
+    free(S.best_R);
+    free(S.R);
+    free(S.sc.slab);
     nb_free(&nb);
 
     return S.best_size;
 }
 
-static void BK_count_all(Bitset *R, int sizeR, Bitset *P,
-                         const NBMasks *nb, long long *cnt)
-{
-    if (sizeR >= 3) (*cnt)++;  
-
-    Bitset Pc = bs_make(P->nbits);
-    bs_copy(&Pc, P);
+/* Copies u's neighbours (ascending) into out and returns how many. */
+static int neighbours(const Graph *g, int u, int *out){
+    int n = 0;
+    if (g->csr) {
+        for (int a=g->off[u]; a<g->off[u+1]; ++a) out[n++] = g->nbr[a];
+        return n;
+    }
+    const uint64_t *row = adj_row(g, u);
+    for (int k=0; k<(g->V + 63) / 64; ++k)
+        for (uint64_t m=row[k]; m; m &= m-1) out[n++] = (k<<6) + __builtin_ctzll(m);
+    return n;
+}
 
-    for (int word = 0; word < Pc.nwords; ++word) {
-        uint64_t mask = Pc.w[word];
-        while (mask) {
-            int bit = __builtin_ctzll(mask);
-            int v = (word << 6) + bit;
-            if (v >= Pc.nbits) break;
-            mask &= (mask - 1);
+/* Smallest-last (degeneracy) ordering by bucket queue, O(V + E): order[i]
+   is the i-th vertex peeled and core[v] its core number. Returns the
+   degeneracy. Either output may be NULL. */
+static int degeneracy_order(const Graph *g, int *order, int *core){
+    const int V = g->V;
+    int maxdeg = 0;
+    for (int v=0; v<V; ++v) if (g->deg[v] > maxdeg) maxdeg = g->deg[v];
+    int *d    = malloc(((size_t)V + 1) * sizeof(int));
+    int *bin  = calloc((size_t)maxdeg + 2, sizeof(int));
+    int *vert = malloc(((size_t)V + 1) * sizeof(int));
+    int *pos  = malloc(((size_t)V + 1) * sizeof(int));
+    int *nb   = malloc(((size_t)maxdeg + 1) * sizeof(int));
+    if (!d || !bin || !vert || !pos || !nb) { perror("malloc"); exit(1); }
+
+    for (int v=0; v<V; ++v) { d[v] = g->deg[v]; bin[d[v]]++; }
+    for (int k=0, start=0; k<=maxdeg; ++k) { int c = bin[k]; bin[k] = start; start += c; }
+    for (int v=0; v<V; ++v) { pos[v] = bin[d[v]]; vert[pos[v]] = v; bin[d[v]]++; }
+    for (int k=maxdeg; k>0; --k) bin[k] = bin[k-1];
+    bin[0] = 0;
+
+    int degen = 0;
+    for (int i=0; i<V; ++i) {
+        int v = vert[i];
+        if (d[v] > degen) degen = d[v];
+        if (order) order[i] = v;
+        if (core) core[v] = d[v];
+        int n = neighbours(g, v, nb);
+        for (int j=0; j<n; ++j) {
+            int u = nb[j];
+            if (d[u] <= d[v]) continue;          /* already peeled or same shell */
+            int du = d[u], pu = pos[u], pw = bin[du], w = vert[pw];
+            if (u != w) { pos[u] = pw; vert[pu] = w; pos[w] = pu; vert[pw] = u; }
+            bin[du]++;
+            d[u]--;
+        }
+    }
+    free(d); free(bin); free(vert); free(pos); free(nb);
+    return degen;
+}
 
-            bs_clear(P, v);
+/* Branch and bound in the style of Tomita's MCS / San Segundo's BBMC.
+   Vertices are renumbered by reverse degeneracy order, so the densest core
+   gets the lowest ids. At every node P is greedily colored with bitset
+   color classes (each class = a maximal run of pairwise non-adjacent
+   vertices taken in id order), and |C| + color(v) bounds any clique that
+   branches on v. Vertices whose color cannot beat the incumbent are never
+   branched on; the rest are tried from the highest color down. */
+typedef struct {
+    int best_size;
+    int *shared_best;   /* parallel workers: global incumbent size, else NULL */
+    int *best_C, *C;
+    const Bitset *N;    /* adjacency in renumbered ids */
+    BKScratch sc;       /* per depth: P, U (uncolored), Q (current class) */
+    int *list, *col;    /* per depth: branch candidates and their colors */
+    int V, lcap;        /* level 0 holds V entries, deeper ones lcap (maxdeg) */
+} BBState;
+
+static inline size_t bb_list_off(const BBState *S, int depth){
+    return depth == 0 ? 0 : (size_t)S->V + (size_t)(depth - 1) * S->lcap;
+}
+
+static inline int bb_best(const BBState *S){
+    return S->shared_best ? __atomic_load_n(S->shared_best, __ATOMIC_RELAXED) : S->best_size;
+}
+
+/* Workers only publish the size; the witness is recovered afterwards. */
+static void bb_improve(BBState *S, int size){
+    if (!S->shared_best) {
+        S->best_size = size;
+        memcpy(S->best_C, S->C, (size_t)size * sizeof(int));
+        return;
+    }
+    int cur = __atomic_load_n(S->shared_best, __ATOMIC_RELAXED);
+    while (size > cur &&
+           !__atomic_compare_exchange_n(S->shared_best, &cur, size, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+static void BB_expand(int depth, BBState *S){
+    Bitset P = bk_slot(&S->sc, depth, 0), U = bk_slot(&S->sc, depth, 1), Q = bk_slot(&S->sc, depth, 2);
+    int *list = S->list + bb_list_off(S, depth), *col = S->col + bb_list_off(S, depth);
+
+    int kmin = bb_best(S) - depth + 1, cnt = 0;
+    bs_copy(&U, &P);
+    for (int k = 1; !bs_empty(&U); ++k) {
+        bs_copy(&Q, &U);
+        for (int word = 0; word < Q.nwords; ++word) {
+            while (Q.w[word]) {
+                int v = (word << 6) + __builtin_ctzll(Q.w[word]);
+                bs_clear(&U, v);
+                bs_clear(&Q, v);
+                bs_minus(&Q, &S->N[v]);
+                if (k >= kmin) { list[cnt] = v; col[cnt] = k; cnt++; }
+            }
+        }
+    }
+
+    Bitset Pp = bk_slot(&S->sc, depth + 1, 0);
+    for (int i = cnt - 1; i >= 0; --i) {
+        if (depth + col[i] <= bb_best(S)) return;
+        int v = list[i];
+        S->C[depth] = v;
+        bs_and_into(&Pp, &P, &S->N[v]);
+        if (bs_empty(&Pp)) {
+            if (depth + 1 > bb_best(S)) bb_improve(S, depth + 1);
+        } else {
+            BB_expand(depth + 1, S);
+        }
+        bs_clear(&P, v);
+    }
+}
+
+/* Read-only renumbered graph shared by every BBState. */
+typedef struct {
+    int V, degen, lcap;
+    int *order;         /* renumbered id x is original vertex order[V-1-x] */
+    Bitset *N;
+} BBGraph;
+
+static void bb_graph_make(const Graph *g, BBGraph *B){
+    const int V = g->V;
+    int *rank = malloc((size_t)V * sizeof(int));
+    int *nb   = malloc((size_t)V * sizeof(int));
+    B->V = V;
+    B->order = malloc((size_t)V * sizeof(int));
+    B->N = malloc((size_t)V * sizeof(Bitset));
+    if (!rank || !nb || !B->order || !B->N) { perror("malloc"); exit(1); }
+    B->degen = degeneracy_order(g, B->order, NULL);
+    for (int i = 0; i < V; ++i) rank[B->order[i]] = V - 1 - i;   /* last peeled -> id 0 */
+
+    B->lcap = 0;
+    for (int i = 0; i < V; ++i) B->N[i] = bs_make(V);
+    for (int v = 0; v < V; ++v) {
+        int n = neighbours(g, v, nb);
+        for (int j = 0; j < n; ++j) bs_set(&B->N[rank[v]], rank[nb[j]]);
+        if (n > B->lcap) B->lcap = n;
+    }
+    free(rank); free(nb);
+}
+
+static void bb_graph_free(BBGraph *B){
+    for (int i = 0; i < B->V; ++i) bs_free(&B->N[i]);
+    free(B->N); free(B->order);
+}
+
+static void bb_state_make(const Graph *g, const BBGraph *B, BBState *S){
+    S->best_size = 0;
+    S->shared_best = NULL;
+    S->N = B->N;
+    S->sc = bk_scratch_make(g, 3);
+    S->V = B->V;
+    S->lcap = B->lcap;
+    /* a clique has at most degen + 1 vertices, so depth never exceeds that */
+    const size_t lsz = bb_list_off(S, B->degen + 2) + 1;
+    S->list = malloc(lsz * sizeof(int));
+    S->col  = malloc(lsz * sizeof(int));
+    S->C      = malloc(((size_t)B->V + 1) * sizeof(int));
+    S->best_C = malloc(((size_t)B->V + 1) * sizeof(int));
+    if (!S->list || !S->col || !S->C || !S->best_C) { perror("malloc"); exit(1); }
+}
+
+static void bb_state_free(BBState *S){
+    free(S->sc.slab); free(S->list); free(S->col); free(S->C); free(S->best_C);
+}
+
+/* Sequential search from incumbent `floor`; the clique it ends with is the
+   first one of maximum size in branching order, whatever the floor was, as
+   long as floor < omega. */
+static int bb_solve(const Graph *g, const BBGraph *B, int floor, int *clique_out, int *clique_size_out){
+    BBState S;
+    bb_state_make(g, B, &S);
+    S.best_size = floor;
+    Bitset P = bk_slot(&S.sc, 0, 0);
+    for (int v = 0; v < B->V; ++v) bs_set(&P, v);
+    BB_expand(0, &S);
+
+    for (int i = 0; i < S.best_size; ++i) S.best_C[i] = B->order[B->V - 1 - S.best_C[i]];
+    qsort(S.best_C, (size_t)S.best_size, sizeof(int), cmp_int);
+    if (clique_out) memcpy(clique_out, S.best_C, (size_t)S.best_size * sizeof(int));
+    if (clique_size_out) *clique_size_out = S.best_size;
+    int best = S.best_size;
+    bb_state_free(&S);
+    return best;
+}
+
+static int bb_max_clique_seq(const Graph *g, int *clique_out, int *clique_size_out){
+    csr_require(g);
+    if (g->V == 0) { if (clique_size_out) *clique_size_out = 0; return 0; }
+    BBGraph B;
+    bb_graph_make(g, &B);
+    int best = bb_solve(g, &B, 0, clique_out, clique_size_out);
+    bb_graph_free(&B);
+    return best;
+}
+
+/* Parallel branch and bound. The root is colored once; each root branch
+   (list[i] with candidates list[0..i-1] ∩ N) is a task. Tasks are dealt
+   round-robin from the most promising end, owners take from the front of
+   their deque and idle workers steal from the back of someone else's. */
+typedef struct {
+    int *task, head, tail;
+    pthread_mutex_t mtx;
+} BBDeque;
+
+typedef struct {
+    const Graph *g;
+    const BBGraph *B;
+    const int *list, *col, *pos;   /* root coloring; pos[v] = index in list */
+    BBDeque *dq;
+    int nthreads;
+    int best;                      /* shared incumbent size */
+} BBPool;
+
+typedef struct { BBPool *pool; int id; } BBWorker;
+
+static int bb_take(BBPool *pool, int id){
+    for (int k = 0; k < pool->nthreads; ++k) {
+        BBDeque *d = &pool->dq[(id + k) % pool->nthreads];
+        int t = -1;
+        pthread_mutex_lock(&d->mtx);
+        if (d->head < d->tail) t = (k == 0) ? d->task[d->head++] : d->task[--d->tail];
+        pthread_mutex_unlock(&d->mtx);
+        if (t >= 0) return t;
+    }
+    return -1;
+}
+
+static void* bb_worker_main(void *arg){
+    BBWorker *wk = arg;
+    BBPool *pool = wk->pool;
+    const BBGraph *B = pool->B;
+    BBState S;
+    bb_state_make(pool->g, B, &S);
+    S.shared_best = &pool->best;
+
+    Bitset P = bk_slot(&S.sc, 1, 0);
+    for (int i; (i = bb_take(pool, wk->id)) >= 0; ) {
+        if (pool->col[i] <= bb_best(&S)) continue;
+        int v = pool->list[i];
+        S.C[0] = v;
+        bs_zero(&P);
+        const Bitset *nv = &B->N[v];
+        for (int word = 0; word < nv->nwords; ++word) {
+            for (uint64_t m = nv->w[word]; m; m &= m - 1) {
+                int u = (word << 6) + __builtin_ctzll(m);
+                if (pool->pos[u] < i) bs_set(&P, u);
+            }
+        }
+        if (bs_empty(&P)) bb_improve(&S, 1);
+        else BB_expand(1, &S);
+    }
+    bb_state_free(&S);
+    return NULL;
+}
+
+static int bb_max_clique(const Graph *g, int nthreads, int *clique_out, int *clique_size_out){
+    csr_require(g);
+    const int V = g->V;
+    if (nthreads > V) nthreads = V;
+    if (nthreads <= 1) return bb_max_clique_seq(g, clique_out, clique_size_out);
+
+    BBGraph B;
+    bb_graph_make(g, &B);
+
+    /* root coloring with an empty incumbent: every vertex gets a slot */
+    BBState R;
+    bb_state_make(g, &B, &R);
+    Bitset P = bk_slot(&R.sc, 0, 0), U = bk_slot(&R.sc, 0, 1), Q = bk_slot(&R.sc, 0, 2);
+    int *pos = malloc((size_t)V * sizeof(int));
+    if (!pos) { perror("malloc"); exit(1); }
+    int cnt = 0;
+    for (int v = 0; v < V; ++v) bs_set(&P, v);
+    bs_copy(&U, &P);
+    for (int k = 1; !bs_empty(&U); ++k) {
+        bs_copy(&Q, &U);
+        for (int word = 0; word < Q.nwords; ++word) {
+            while (Q.w[word]) {
+                int v = (word << 6) + __builtin_ctzll(Q.w[word]);
+                bs_clear(&U, v);
+                bs_clear(&Q, v);
+                bs_minus(&Q, &B.N[v]);
+                R.list[cnt] = v; R.col[cnt] = k; pos[v] = cnt++;
+            }
+        }
+    }
+
+    BBPool pool = { g, &B, R.list, R.col, pos, NULL, nthreads, 0 };
+    pool.dq = calloc((size_t)nthreads, sizeof(BBDeque));
+    BBWorker *wk = malloc((size_t)nthreads * sizeof(BBWorker));
+    pthread_t *tid = malloc((size_t)nthreads * sizeof(pthread_t));
+    if (!pool.dq || !wk || !tid) { perror("malloc"); exit(1); }
+    for (int t = 0; t < nthreads; ++t) {
+        pool.dq[t].task = malloc(((size_t)cnt / nthreads + 1) * sizeof(int));
+        if (!pool.dq[t].task) { perror("malloc"); exit(1); }
+        pthread_mutex_init(&pool.dq[t].mtx, NULL);
+    }
+    for (int s = 0; s < cnt; ++s) {
+        BBDeque *d = &pool.dq[s % nthreads];
+        d->task[d->tail++] = cnt - 1 - s;
+    }
+
+    for (int t = 0; t < nthreads; ++t) {
+        wk[t] = (BBWorker){ &pool, t };
+        if (t > 0 && pthread_create(&tid[t], NULL, bb_worker_main, &wk[t]) != 0) {
+            perror("pthread_create"); exit(1);
+        }
+    }
+    bb_worker_main(&wk[0]);
+    for (int t = 1; t < nthreads; ++t) pthread_join(tid[t], NULL);
+
+    /* Which worker hit omega first is a race, so the witness comes from a
+       sequential pass that only has to find a clique of size omega, not
+       prove it optimal. It returns exactly what bb_max_clique_seq would. */
+    int best = bb_solve(g, &B, pool.best - 1, clique_out, clique_size_out);
+
+    for (int t = 0; t < nthreads; ++t) {
+        pthread_mutex_destroy(&pool.dq[t].mtx);
+        free(pool.dq[t].task);
+    }
+    free(pool.dq); free(wk); free(tid); free(pos);
+    bb_state_free(&R);
+    bb_graph_free(&B);
+    return best;
+}
+
+/* Graph reductions. The exact clique and Hamilton engines are exponential
+   in V, so they run on a smaller relabeled graph and their answers are
+   mapped back through orig[] (and, for Hamilton, the collapsed chains). */
+
+/* Subgraph induced by vert[0..n), where newid[vert[i]] = i and every
+   other vertex has newid -1; weights are kept. Costs O(n + edges). */
+static Graph *induced_subgraph(const Graph *g, const int *newid, const int *vert, int n){
+    int maxdeg = 0;
+    for (int i = 0; i < n; ++i) if (g->deg[vert[i]] > maxdeg) maxdeg = g->deg[vert[i]];
+    int *nb = malloc(((size_t)maxdeg + 1) * sizeof(int));
+    if (!nb) { perror("malloc"); exit(1); }
+    long long m = 0;
+    for (int i = 0; i < n; ++i) {
+        int u = vert[i], d = neighbours(g, u, nb);
+        for (int j = 0; j < d; ++j) m += nb[j] > u && newid[nb[j]] >= 0;
+    }
+    Graph *h = create_graph_sized(n, m);
+    for (int i = 0; i < n; ++i) {
+        int u = vert[i], d = neighbours(g, u, nb);
+        for (int j = 0; j < d; ++j)
+            if (nb[j] > u && newid[nb[j]] >= 0) graph_add_edge(h, i, newid[nb[j]], graph_weight(g, u, nb[j]));
+    }
+    graph_finalize(h);
+    free(nb);
+    return h;
+}
+
+int graph_reduce_core(const Graph *g, int lb, GraphReduction *r){
+    const int V = g->V;
+    int *order  = malloc(((size_t)V + 1) * sizeof(int));
+    int *core   = malloc(((size_t)V + 1) * sizeof(int));
+    int *newid  = malloc(((size_t)V + 1) * sizeof(int));
+    if (!order || !core || !newid) { perror("malloc"); exit(1); }
+    degeneracy_order(g, order, core);
+    /* core[] holds the degree at peeling time; the core number is the
+       largest such degree peeled so far */
+    for (int i = 0, k = 0; i < V; ++i) { if (core[order[i]] > k) k = core[order[i]]; core[order[i]] = k; }
+
+    int n = 0;
+    for (int v = 0; v < V; ++v) newid[v] = core[v] >= lb ? n++ : -1;
+    memset(r, 0, sizeof(*r));
+    r->orig = malloc(((size_t)n + 1) * sizeof(int));
+    if (!r->orig) { perror("malloc"); exit(1); }
+    for (int v = 0; v < V; ++v) if (newid[v] >= 0) r->orig[newid[v]] = v;
+    r->g = induced_subgraph(g, newid, r->orig, n);
+
+    free(order); free(core); free(newid);
+    return n;
+}
+
+void graph_reduction_free(GraphReduction *r){
+    if (r->g) free_graph(r->g);
+    free(r->orig); free(r->chain_off); free(r->chain); free(r->chain_from);
+    memset(r, 0, sizeof(*r));
+}
+
+/* Greedy clique for a lower bound: from each of the GREEDY_SEEDS vertices
+   peeled last, add neighbours latest-peeled first while they stay
+   adjacent to everything taken. Returns the largest size found. */
+#define GREEDY_SEEDS 16
+
+static int clique_greedy(const Graph *g, int *clique_out){
+    const int V = g->V;
+    int maxdeg = 0;
+    for (int v = 0; v < V; ++v) if (g->deg[v] > maxdeg) maxdeg = g->deg[v];
+    int *order = malloc((size_t)V * sizeof(int));
+    int *pos   = malloc((size_t)V * sizeof(int));
+    int *nb    = malloc(((size_t)maxdeg + 1) * sizeof(int));
+    int *C     = malloc(((size_t)maxdeg + 1) * sizeof(int));
+    if (!order || !pos || !nb || !C) { perror("malloc"); exit(1); }
+    degeneracy_order(g, order, NULL);
+    for (int i = 0; i < V; ++i) pos[order[i]] = i;
+
+    int best = 0;
+    for (int s = V - 1; s >= 0 && s >= V - GREEDY_SEEDS; --s) {
+        int v = order[s], d = neighbours(g, v, nb), c = 0;
+        if (d + 1 <= best) continue;
+        for (int j = 0; j < d; ++j) nb[j] = pos[nb[j]];
+        qsort(nb, (size_t)d, sizeof(int), cmp_int);
+        C[c++] = v;
+        for (int j = d - 1; j >= 0; --j) {
+            int u = order[nb[j]], ok = 1;
+            for (int t = 1; t < c && ok; ++t) ok = graph_has_edge(g, u, C[t]);
+            if (ok) C[c++] = u;
+        }
+        if (c > best) { best = c; memcpy(clique_out, C, (size_t)c * sizeof(int)); }
+    }
+    free(order); free(pos); free(nb); free(C);
+    return best;
+}
+
+typedef int (*CliqueEngine)(const Graph *g, int nthreads, int *clique_out, int *clique_size_out);
+
+/* Runs solve on the core that could still hold a clique larger than the
+   greedy one and reports whichever is larger, in original ids. */
+static int clique_reduced(const Graph *g, int nthreads, CliqueEngine solve, int *clique_out, int *clique_size_out){
+    csr_require(g);
+    const int V = g->V;
+    if (V == 0) { if (clique_size_out) *clique_size_out = 0; return 0; }
+
+    int *best_C = malloc((size_t)V * sizeof(int));
+    if (!best_C) { perror("malloc"); exit(1); }
+    int best = clique_greedy(g, best_C);
+    if (best == 1) best_C[0] = 0;      /* no edges: report vertex 0, as the exact engines do */
+
+    GraphReduction r;
+    int n = graph_reduce_core(g, best, &r);
+    if (n > best) {
+        int *cl = malloc((size_t)n * sizeof(int)), got = 0;
+        if (!cl) { perror("malloc"); exit(1); }
+        int k = solve(r.g, nthreads, cl, &got);
+        if (k > best) {
+            best = k;
+            for (int i = 0; i < k; ++i) best_C[i] = r.orig[cl[i]];
+        }
+        free(cl);
+    }
+    graph_reduction_free(&r);
+
+    qsort(best_C, (size_t)best, sizeof(int), cmp_int);
+    if (clique_out) memcpy(clique_out, best_C, (size_t)best * sizeof(int));
+    if (clique_size_out) *clique_size_out = best;
+    free(best_C);
+    return best;
+}
+
+/* Connected components. Problems that decompose over components are
+   solved on every component's own subgraph, so the V-sized structures of
+   the engines shrink to the component, and the components run in
+   parallel, largest first. A graph with one component that matters is
+   handed to the engine whole, with all threads. */
+int graph_components(const Graph *g, int *comp_of){
+    const int V = g->V;
+    int *uf = malloc(((size_t)V + 1) * sizeof(int));
+    int *id = malloc(((size_t)V + 1) * sizeof(int));
+    if (!uf || !id) { perror("malloc"); exit(1); }
+    memcpy(uf, g->uf, (size_t)V * sizeof(int));
+    int n = 0;
+    for (int v = 0; v < V; ++v) id[v] = -1;
+    for (int v = 0; v < V; ++v) {
+        int r = uf_find(uf, v);
+        if (id[r] < 0) id[r] = n++;
+        comp_of[v] = id[r];
+    }
+    free(uf); free(id);
+    return n;
+}
+
+/* fn gets component c as its own graph, with orig[x] the original id of
+   vertex x, and the number of threads it may use. Calls for different
+   components may run at the same time. */
+typedef void (*ComponentFn)(const Graph *sub, const int *orig, int c, int nthreads, void *ctx);
+
+typedef struct {
+    const Graph *g;
+    const int *off, *vert, *task;   /* members of c: vert[off[c] .. off[c+1]) */
+    int ntask, next;
+    ComponentFn fn;
+    void *ctx;
+} CompJob;
+
+static void* comp_worker_main(void *arg){
+    CompJob *J = arg;
+    int *newid = malloc(((size_t)J->g->V + 1) * sizeof(int));
+    if (!newid) { perror("malloc"); exit(1); }
+    for (int v = 0; v < J->g->V; ++v) newid[v] = -1;
+    for (int t; (t = __atomic_fetch_add(&J->next, 1, __ATOMIC_RELAXED)) < J->ntask; ) {
+        int c = J->task[t], n = J->off[c + 1] - J->off[c];
+        const int *vert = J->vert + J->off[c];
+        for (int i = 0; i < n; ++i) newid[vert[i]] = i;
+        Graph *sub = induced_subgraph(J->g, newid, vert, n);
+        for (int i = 0; i < n; ++i) newid[vert[i]] = -1;
+        J->fn(sub, vert, c, 1, J->ctx);
+        free_graph(sub);
+    }
+    free(newid);
+    return NULL;
+}
+
+/* Runs fn on every component of at least min_size vertices, ncomp
+   components in all as numbered by graph_components. */
+static void for_each_component(const Graph *g, const int *comp_of, int ncomp, int min_size,
+                               int nthreads, ComponentFn fn, void *ctx){
+    const int V = g->V;
+    int *off  = calloc((size_t)ncomp + 2, sizeof(int));
+    int *vert = malloc(((size_t)V + 1) * sizeof(int));
+    int *task = malloc(((size_t)ncomp + 1) * sizeof(int));
+    if (!off || !vert || !task) { perror("malloc"); exit(1); }
+    for (int v = 0; v < V; ++v) off[comp_of[v] + 2]++;
+    for (int c = 0; c < ncomp; ++c) off[c + 2] += off[c + 1];
+    for (int v = 0; v < V; ++v) vert[off[comp_of[v] + 1]++] = v;   /* ascending within c */
+
+    /* largest first, by counting sort on size (ties keep id order) */
+    int ntask = 0, maxsz = 0;
+    for (int c = 0; c < ncomp; ++c) if (off[c + 1] - off[c] > maxsz) maxsz = off[c + 1] - off[c];
+    int *cnt = calloc((size_t)maxsz + 2, sizeof(int));
+    if (!cnt) { perror("calloc"); exit(1); }
+    for (int c = 0; c < ncomp; ++c) if (off[c + 1] - off[c] >= min_size) cnt[maxsz - (off[c + 1] - off[c]) + 1]++;
+    for (int s = 0; s <= maxsz; ++s) cnt[s + 1] += cnt[s];
+    for (int c = 0; c < ncomp; ++c)
+        if (off[c + 1] - off[c] >= min_size) { task[cnt[maxsz - (off[c + 1] - off[c])]++] = c; ntask++; }
+    free(cnt);
+
+    if (ntask == 1 && off[task[0] + 1] - off[task[0]] == V) {
+        fn(g, vert, task[0], nthreads, ctx);              /* vert is the identity here */
+    } else if (ntask == 1) {
+        int *newid = malloc(((size_t)V + 1) * sizeof(int));
+        if (!newid) { perror("malloc"); exit(1); }
+        for (int v = 0; v < V; ++v) newid[v] = -1;
+        int c = task[0], n = off[c + 1] - off[c];
+        for (int i = 0; i < n; ++i) newid[vert[off[c] + i]] = i;
+        Graph *sub = induced_subgraph(g, newid, vert + off[c], n);
+        fn(sub, vert + off[c], c, nthreads, ctx);
+        free_graph(sub); free(newid);
+    } else if (ntask > 1) {
+        CompJob J = { g, off, vert, task, ntask, 0, fn, ctx };
+        if (nthreads < 1) nthreads = 1;
+        if (nthreads > ntask) nthreads = ntask;
+        pthread_t *tid = malloc((size_t)nthreads * sizeof(pthread_t));
+        if (!tid) { perror("malloc"); exit(1); }
+        for (int t = 1; t < nthreads; ++t)
+            if (pthread_create(&tid[t], NULL, comp_worker_main, &J) != 0) { perror("pthread_create"); exit(1); }
+        comp_worker_main(&J);
+        for (int t = 1; t < nthreads; ++t) pthread_join(tid[t], NULL);
+        free(tid);
+    }
+    free(off); free(vert); free(task);
+}
+
+static void mst_comp_fn(const Graph *sub, const int *orig, int c, int nthreads, void *ctx){
+    (void)orig;
+    ((long long *)ctx)[c] = mst_weight(sub, nthreads, NULL);
+}
+
+long long mst_forest(const Graph *g, int nthreads, long long *comp_weight){
+    const int V = g->V;
+    if (V == 0) return 0;
+    csr_require(g);
+    int *comp_of = malloc((size_t)V * sizeof(int));
+    if (!comp_of) { perror("malloc"); exit(1); }
+    int n = graph_components(g, comp_of);
+    long long *cw = comp_weight ? comp_weight : malloc((size_t)n * sizeof(long long));
+    if (!cw) { perror("malloc"); exit(1); }
+    memset(cw, 0, (size_t)n * sizeof(long long));
+    for_each_component(g, comp_of, n, 2, nthreads, mst_comp_fn, cw);
+
+    long long total = 0;
+    for (int c = 0; c < n; ++c) total += cw[c];
+    if (!comp_weight) free(cw);
+    free(comp_of);
+    return total;
+}
+
+typedef struct {
+    CliqueEngine solve;
+    int best;           /* largest clique so far, shared */
+    int *size;          /* per component; 0 if skipped */
+    int **clq;          /* per component, original ids */
+} CliqueCompJob;
+
+static void clique_comp_fn(const Graph *sub, const int *orig, int c, int nthreads, void *ctx){
+    CliqueCompJob *J = ctx;
+    /* a component that cannot even tie is skipped, so the pick below
+       does not depend on timing */
+    if (sub->V < __atomic_load_n(&J->best, __ATOMIC_RELAXED)) return;
+    int *cl = malloc((size_t)sub->V * sizeof(int)), got = 0;
+    if (!cl) { perror("malloc"); exit(1); }
+    int k = clique_reduced(sub, nthreads, J->solve, cl, &got);
+    for (int i = 0; i < k; ++i) cl[i] = orig[cl[i]];
+    J->size[c] = k;
+    J->clq[c] = cl;
+    int cur = __atomic_load_n(&J->best, __ATOMIC_RELAXED);
+    while (k > cur && !__atomic_compare_exchange_n(&J->best, &cur, k, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+/* Largest clique over the components; on ties the component with the
+   smallest vertex wins. */
+static int clique_components(const Graph *g, int nthreads, CliqueEngine solve, int *clique_out, int *clique_size_out){
+    const int V = g->V;
+    if (V == 0 || g->E == 0 || g->ncomp == 1) return clique_reduced(g, nthreads, solve, clique_out, clique_size_out);
+    csr_require(g);
+
+    int *comp_of = malloc((size_t)V * sizeof(int));
+    if (!comp_of) { perror("malloc"); exit(1); }
+    int n = graph_components(g, comp_of);
+    CliqueCompJob J = { solve, 0, calloc((size_t)n, sizeof(int)), calloc((size_t)n, sizeof(int *)) };
+    if (!J.size || !J.clq) { perror("calloc"); exit(1); }
+    for_each_component(g, comp_of, n, 2, nthreads, clique_comp_fn, &J);
+
+    int pick = -1;
+    for (int c = 0; c < n; ++c) if (J.size[c] == J.best && pick < 0) pick = c;
+    if (clique_out) memcpy(clique_out, J.clq[pick], (size_t)J.best * sizeof(int));
+    if (clique_size_out) *clique_size_out = J.best;
+    for (int c = 0; c < n; ++c) free(J.clq[c]);
+    free(J.size); free(J.clq); free(comp_of);
+    return J.best;
+}
+
+/* CSR graphs go to max_clique_sparse: both engines below would build a
+   V-bit row for every vertex of the core. */
+int max_clique(const Graph *g, int *clique_out, int *clique_size_out){
+    if (g->csr) return max_clique_sparse(g, 1, clique_out, clique_size_out);
+    return clique_components(g, 1, bk_max_clique, clique_out, clique_size_out);
+}
+
+int max_clique_bb(const Graph *g, int *clique_out, int *clique_size_out){
+    if (g->csr) return max_clique_sparse(g, 1, clique_out, clique_size_out);
+    return clique_components(g, 1, bb_max_clique, clique_out, clique_size_out);
+}
+
+int max_clique_bb_mt(const Graph *g, int nthreads, int *clique_out, int *clique_size_out){
+    if (g->csr) return max_clique_sparse(g, nthreads, clique_out, clique_size_out);
+    return clique_components(g, nthreads, bb_max_clique, clique_out, clique_size_out);
+}
+
+/* Clique counting by pivoting (Jain & Seshadhri's Pivoter). Each vertex v
+   roots the cliques whose earliest vertex in degeneracy order is v, inside
+   the subgraph of its later neighbours (at most degen vertices, so local
+   bitsets stay small). Below a node with candidates P and pivot u, every
+   clique either lies in N(u) with u optional, or contains a first
+   non-neighbour x of u. The u branch marks u as a pivot, the x branches
+   hold x. A leaf with h held and p pivot vertices stands for the C(p, j)
+   cliques of size h + j, so no clique is visited on its own. */
+typedef struct {
+    const Bitset *LN;   /* local adjacency of the root's later neighbours */
+    BKScratch sc;       /* per depth: P, P \ N(pivot) */
+    unsigned __int128 *hist;   /* hist[k] = cliques with k vertices */
+    int overflow;
+} PivState;
+
+static int u128_add(unsigned __int128 *acc, unsigned __int128 x){
+    return __builtin_add_overflow(*acc, x, acc);
+}
+
+static void piv_leaf(PivState *S, int held, int piv){
+    unsigned __int128 c = 1;               /* C(piv, j), exact while it fits */
+    for (int j = 0; j <= piv; ++j) {
+        if (j > 0) {
+            /* c * (piv-j+1) / j without the intermediate product: with
+               d = gcd(c mod j, j), j/d divides (piv-j+1) */
+            int a = (int)(c % (unsigned)j), d = j;
+            while (a) { int t = d % a; d = a; a = t; }
+            unsigned __int128 m = (unsigned)((piv - j + 1) / (j / d));
+            if (__builtin_mul_overflow(c / (unsigned)d, m, &c)) { S->overflow = 1; return; }
+        }
+        if (u128_add(&S->hist[held + j], c)) { S->overflow = 1; return; }
+    }
+}
 
-            Bitset Rp = bs_make(R->nbits);
-            bs_copy(&Rp, R);
-            bs_set(&Rp, v);
+static void piv_recurse(PivState *S, int depth, int held, int piv){
+    if (S->overflow) return;
+    Bitset P = bk_slot(&S->sc, depth, 0);
+    int size = bs_count(&P);
+    if (size == 0) { piv_leaf(S, held, piv); return; }
+
+    int u = -1, best = -1, low = size;
+    for (int word = 0; word < P.nwords; ++word)
+        for (uint64_t m = P.w[word]; m; m &= m - 1) {
+            int x = (word << 6) + __builtin_ctzll(m);
+            int d = bs_and_count(&P, &S->LN[x]);
+            if (d > best) { best = d; u = x; }
+            if (d < low) low = d;
+        }
+    if (low == size - 1) { piv_leaf(S, held, piv + size); return; }   /* P is a clique */
+
+    Bitset X = bk_slot(&S->sc, depth, 1), Pp = bk_slot(&S->sc, depth + 1, 0);
+    bs_copy(&X, &P);
+    bs_minus(&X, &S->LN[u]);
+    for (int word = 0; word < X.nwords; ++word)
+        for (uint64_t m = X.w[word]; m; m &= m - 1) {
+            int x = (word << 6) + __builtin_ctzll(m);
+            bs_and_into(&Pp, &P, &S->LN[x]);
+            if (x == u) piv_recurse(S, depth + 1, held, piv + 1);
+            else        piv_recurse(S, depth + 1, held + 1, piv);
+            bs_clear(&P, x);
+        }
+}
 
-            Bitset Pp = bs_make(P->nbits);
-            bs_copy(&Pp, P);
-            bs_and(&Pp, &nb->N[v]);
+/* Stores the neighbours of order[i] that come after it in the ordering
+   in nb[0..k) and their adjacency among themselves in LN[0..k), and
+   returns k. nb needs maxdeg + 1 entries, LN at least k rows. CSR graphs
+   scan each neighbour's list against loc (V entries, all -1 on entry and
+   on return) instead of testing k^2 pairs by binary search. */
+static int later_nbhood(const Graph *g, const int *order, const int *pos, int i, int *nb, int *loc, Bitset *LN){
+    int k = 0, n = neighbours(g, order[i], nb);
+    for (int j = 0; j < n; ++j) if (pos[nb[j]] > i) nb[k++] = nb[j];
+    for (int a = 0; a < k; ++a) bs_zero(&LN[a]);
+    if (g->csr) {
+        for (int a = 0; a < k; ++a) loc[nb[a]] = a;
+        for (int a = 0; a < k; ++a)
+            for (int e = g->off[nb[a]]; e < g->off[nb[a] + 1]; ++e)
+                if (loc[g->nbr[e]] >= 0) bs_set(&LN[a], loc[g->nbr[e]]);
+        for (int a = 0; a < k; ++a) loc[nb[a]] = -1;
+        return k;
+    }
+    for (int a = 0; a < k; ++a)
+        for (int b = 0; b < k; ++b)
+            if (b != a && adj_test(g, nb[a], nb[b])) bs_set(&LN[a], b);
+    return k;
+}
 
-            BK_count_all(&Rp, sizeR + 1, &Pp, nb, cnt);
+/* Fills hist[0..degen+1] with the number of cliques of every size
+   (hist[0] = 0) and returns degen + 2, the number of entries written, or
+   -1 if some count does not fit in 128 bits. */
+static int clique_histogram(const Graph *g, unsigned __int128 *hist){
+    const int V = g->V;
+    int *order = malloc(((size_t)V + 1) * sizeof(int));
+    int *pos   = malloc(((size_t)V + 1) * sizeof(int));
+    int *nb    = malloc(((size_t)V + 1) * sizeof(int));
+    int *loc   = malloc(((size_t)V + 1) * sizeof(int));
+    if (!order || !pos || !nb || !loc) { perror("malloc"); exit(1); }
+    for (int v = 0; v < V; ++v) loc[v] = -1;
+    int degen = degeneracy_order(g, order, NULL);
+    for (int i = 0; i < V; ++i) pos[order[i]] = i;
+    memset(hist, 0, ((size_t)degen + 2) * sizeof(*hist));
+
+    PivState S;
+    S.hist = hist;
+    S.overflow = 0;
+    S.sc.nbits = degen;
+    S.sc.nwords = (degen + 63) / 64;
+    S.sc.per = 2;
+    S.sc.slab = calloc((size_t)(degen + 3) * 2 * S.sc.nwords + 1, sizeof(uint64_t));
+    Bitset *LN = malloc(((size_t)degen + 1) * sizeof(Bitset));
+    if (!S.sc.slab || !LN) { perror("malloc"); exit(1); }
+    for (int i = 0; i < degen; ++i) LN[i] = bs_make(degen);
+    S.LN = LN;
+
+    for (int i = 0; i < V && !S.overflow; ++i) {
+        int k = later_nbhood(g, order, pos, i, nb, loc, LN);
+        Bitset P = bk_slot(&S.sc, 0, 0);
+        P.nbits = k;
+        bs_zero(&P);
+        for (int a = 0; a < k; ++a) bs_set(&P, a);
+        piv_recurse(&S, 0, 1, 0);
+    }
+
+    for (int i = 0; i < degen; ++i) bs_free(&LN[i]);
+    free(LN); free(S.sc.slab); free(order); free(pos); free(nb); free(loc);
+    return S.overflow ? -1 : degen + 2;
+}
+
+typedef struct {
+    unsigned __int128 **hist;   /* per component */
+    int *len;                   /* entries written, or -1 on overflow */
+} HistCompJob;
+
+static void hist_comp_fn(const Graph *sub, const int *orig, int c, int nthreads, void *ctx){
+    (void)orig; (void)nthreads;
+    HistCompJob *J = ctx;
+    J->hist[c] = malloc(((size_t)sub->V + 2) * sizeof(unsigned __int128));
+    if (!J->hist[c]) { perror("malloc"); exit(1); }
+    J->len[c] = clique_histogram(sub, J->hist[c]);
+}
 
-            bs_free(&Rp);
-            bs_free(&Pp);
+int count_cliques_by_size_mt(const Graph *g, int nthreads, unsigned __int128 *hist)
+{
+    const int V = g->V;
+    if (V == 0) { hist[0] = 0; return 1; }
+    csr_require(g);
+    int *comp_of = malloc((size_t)V * sizeof(int));
+    if (!comp_of) { perror("malloc"); exit(1); }
+    int nc = graph_components(g, comp_of);
+    HistCompJob J = { calloc((size_t)nc, sizeof(unsigned __int128 *)), calloc((size_t)nc, sizeof(int)) };
+    if (!J.hist || !J.len) { perror("calloc"); exit(1); }
+    for_each_component(g, comp_of, nc, 3, nthreads, hist_comp_fn, &J);
+
+    /* components of one or two vertices only hold vertices and an edge */
+    memset(hist, 0, ((size_t)V + 2) * sizeof(*hist));
+    int *csz = calloc((size_t)nc, sizeof(int));
+    if (!csz) { perror("calloc"); exit(1); }
+    for (int v = 0; v < V; ++v) csz[comp_of[v]]++;
+    int n = g->E > 0 ? 3 : 2, over = 0;
+    for (int c = 0; c < nc; ++c) {
+        if (csz[c] < 3) {
+            hist[1] += (unsigned)csz[c];
+            hist[2] += csz[c] == 2;
+            continue;
         }
+        if (J.len[c] < 0) over = 1;
+        for (int k = 0; k < J.len[c] && !over; ++k) over = u128_add(&hist[k], J.hist[c][k]);
+        if (J.len[c] > n) n = J.len[c];
+        free(J.hist[c]);
     }
-    bs_free(&Pc);
+    free(csz); free(J.hist); free(J.len); free(comp_of);
+    if (over) return -1;
+    while (n > 1 && hist[n - 1] == 0) --n;
+    return n;
+}
+
+int count_cliques_by_size(const Graph *g, unsigned __int128 *hist)
+{
+    return count_cliques_by_size_mt(g, 1, hist);
+}
+
+int count_cliques_3plus_exact_mt(const Graph *g, int nthreads, unsigned __int128 *count_out)
+{
+    *count_out = 0;
+    if (g->V <= 2) return 0;
+
+    unsigned __int128 *hist = malloc(((size_t)g->V + 2) * sizeof(*hist));
+    if (!hist) { perror("malloc"); exit(1); }
+    int n = count_cliques_by_size_mt(g, nthreads, hist), rc = (n < 0) ? -1 : 0;
+    for (int k = 3; k < n && rc == 0; ++k)
+        if (u128_add(count_out, hist[k])) rc = -1;
+    free(hist);
+    return rc;
+}
+
+int count_cliques_3plus_exact(const Graph *g, unsigned __int128 *count_out)
+{
+    return count_cliques_3plus_exact_mt(g, 1, count_out);
 }
 
 long long count_cliques_3plus(const Graph *g)
 {
+    unsigned __int128 c;
+    if (count_cliques_3plus_exact(g, &c) != 0 || c > (unsigned __int128)LLONG_MAX) return -1;
+    return (long long)c;
+}
+
+char* u128_to_str(unsigned __int128 x, char *buf)
+{
+    char tmp[40];
+    int n = 0;
+    do { tmp[n++] = (char)('0' + (int)(x % 10)); x /= 10; } while (x);
+    for (int i = 0; i < n; ++i) buf[i] = tmp[n - 1 - i];
+    buf[n] = '\0';
+    return buf;
+}
+
+
+/* Triangle counting. Vertices are ranked by (degree, id) and every edge
+   points to the higher rank, so each triangle is found once, from its
+   lowest-ranked vertex, and hubs keep short out-lists. Dense graphs are
+   relabeled into packed rows and a triangle r < s < w is a bit of
+   row(r) & row(s) above s, counted with an AND + popcount kernel.
+   CSR graphs intersect oriented lists through a per-thread mark array
+   instead, since V x V bits would not fit for them. */
+typedef uint64_t (*AndCountFn)(const uint64_t *a, const uint64_t *b, size_t n);
+
+static uint64_t and_count_scalar(const uint64_t *a, const uint64_t *b, size_t n) {
+    uint64_t c = 0;
+    for (size_t i = 0; i < n; ++i) c += (uint64_t)__builtin_popcountll(a[i] & b[i]);
+    return c;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("popcnt")))
+static uint64_t and_count_popcnt(const uint64_t *a, const uint64_t *b, size_t n) {
+    uint64_t c = 0;
+    for (size_t i = 0; i < n; ++i) c += (uint64_t)__builtin_popcountll(a[i] & b[i]);
+    return c;
+}
+/* nibble lookup popcount (Mula), byte sums folded with SAD */
+__attribute__((target("avx2,popcnt")))
+static uint64_t and_count_avx2(const uint64_t *a, const uint64_t *b, size_t n) {
+    const __m256i lut = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,
+                                         0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+    const __m256i low = _mm256_set1_epi8(0x0f), zero = _mm256_setzero_si256();
+    __m256i acc = zero;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(a + i)),
+                                     _mm256_loadu_si256((const __m256i*)(b + i)));
+        __m256i c = _mm256_add_epi8(_mm256_shuffle_epi8(lut, _mm256_and_si256(v, low)),
+                                    _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(c, zero));
+    }
+    uint64_t c = (uint64_t)_mm256_extract_epi64(acc, 0) + (uint64_t)_mm256_extract_epi64(acc, 1)
+               + (uint64_t)_mm256_extract_epi64(acc, 2) + (uint64_t)_mm256_extract_epi64(acc, 3);
+    for (; i < n; ++i) c += (uint64_t)__builtin_popcountll(a[i] & b[i]);
+    return c;
+}
+__attribute__((target("avx512f,avx512vpopcntdq")))
+static uint64_t and_count_avx512(const uint64_t *a, const uint64_t *b, size_t n) {
+    __m512i acc = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_and_si512(
+                  _mm512_loadu_si512((const void*)(a + i)), _mm512_loadu_si512((const void*)(b + i)))));
+    if (i < n) {
+        __mmask8 m = (__mmask8)((1u << (n - i)) - 1);
+        acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_and_si512(
+                  _mm512_maskz_loadu_epi64(m, a + i), _mm512_maskz_loadu_epi64(m, b + i))));
+    }
+    return (uint64_t)_mm512_reduce_add_epi64(acc);
+}
+#endif
+
+static AndCountFn and_count;
+static pthread_once_t and_count_once = PTHREAD_ONCE_INIT;
+
+static void and_count_pick(void) {
+    and_count = and_count_scalar;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512vpopcntdq"))
+        and_count = and_count_avx512;
+    else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+        and_count = and_count_avx2;
+    else if (__builtin_cpu_supports("popcnt"))
+        and_count = and_count_popcnt;
+#endif
+}
+
+typedef struct {
+    int V, W;               /* W: words per packed row (dense only) */
+    const uint64_t *rows;   /* dense: row r = neighbours of inv[r], by rank */
+    const int *off, *out;   /* CSR: higher-ranked neighbours, by rank */
+    const int *inv;
+    long long *per_vertex;  /* by original id, or NULL */
+    int next;               /* shared cursor over ranks */
+} TriJob;
+
+typedef struct { TriJob *job; long long count; } TriSlice;
+
+#define TRI_CHUNK 64
+
+static void* tri_dense_main(void *arg) {
+    TriSlice *sl = arg;
+    TriJob *J = sl->job;
+    const int W = J->W;
+    for (;;) {
+        int r0 = __atomic_fetch_add(&J->next, TRI_CHUNK, __ATOMIC_RELAXED);
+        if (r0 >= J->V) break;
+        int r1 = r0 + TRI_CHUNK < J->V ? r0 + TRI_CHUNK : J->V;
+        for (int r = r0; r < r1; ++r) {
+            const uint64_t *row = J->rows + (size_t)r * W;
+            long long t = 0;
+            if (J->per_vertex) {
+                /* all triangles at r: every neighbour pair counted twice */
+                for (int k = 0; k < W; ++k)
+                    for (uint64_t m = row[k]; m; m &= m - 1) {
+                        int s = (k << 6) + __builtin_ctzll(m);
+                        t += (long long)and_count(row, J->rows + (size_t)s * W, (size_t)W);
+                    }
+                J->per_vertex[J->inv[r]] = t / 2;
+                continue;
+            }
+            for (int k = (r + 1) >> 6; k < W; ++k) {
+                uint64_t m = row[k];
+                if (k == (r + 1) >> 6) m &= ~UINT64_C(0) << ((r + 1) & 63);
+                for (; m; m &= m - 1) {
+                    int s = (k << 6) + __builtin_ctzll(m), k0 = (s + 1) >> 6;
+                    if (k0 >= W) continue;
+                    const uint64_t *rs = J->rows + (size_t)s * W;
+                    t += __builtin_popcountll(row[k0] & rs[k0] & (~UINT64_C(0) << ((s + 1) & 63)));
+                    t += (long long)and_count(row + k0 + 1, rs + k0 + 1, (size_t)(W - k0 - 1));
+                }
+            }
+            sl->count += t;
+        }
+    }
+    return NULL;
+}
+
+static void* tri_csr_main(void *arg) {
+    TriSlice *sl = arg;
+    TriJob *J = sl->job;
+    int *mark = malloc((size_t)J->V * sizeof(int));
+    if (!mark) { perror("malloc"); exit(1); }
+    for (int i = 0; i < J->V; ++i) mark[i] = -1;
+    for (;;) {
+        int r0 = __atomic_fetch_add(&J->next, TRI_CHUNK, __ATOMIC_RELAXED);
+        if (r0 >= J->V) break;
+        int r1 = r0 + TRI_CHUNK < J->V ? r0 + TRI_CHUNK : J->V;
+        for (int r = r0; r < r1; ++r) {
+            for (int a = J->off[r]; a < J->off[r + 1]; ++a) mark[J->out[a]] = r;
+            for (int a = J->off[r]; a < J->off[r + 1]; ++a) {
+                int s = J->out[a];
+                for (int b = J->off[s]; b < J->off[s + 1]; ++b) {
+                    int w = J->out[b];
+                    if (mark[w] != r) continue;
+                    sl->count++;
+                    if (J->per_vertex) {
+                        __atomic_fetch_add(&J->per_vertex[J->inv[r]], 1, __ATOMIC_RELAXED);
+                        __atomic_fetch_add(&J->per_vertex[J->inv[s]], 1, __ATOMIC_RELAXED);
+                        __atomic_fetch_add(&J->per_vertex[J->inv[w]], 1, __ATOMIC_RELAXED);
+                    }
+                }
+            }
+        }
+    }
+    free(mark);
+    return NULL;
+}
+
+long long count_triangles(const Graph *g, int nthreads, long long *per_vertex) {
     const int V = g->V;
-    if (V <= 2) return 0;
+    if (per_vertex) memset(per_vertex, 0, (size_t)V * sizeof(long long));
+    if (V < 3) return 0;
+    csr_require(g);
+    pthread_once(&and_count_once, and_count_pick);
+
+    /* rank by (degree, id): counting sort on degree */
+    int maxdeg = 0;
+    for (int v = 0; v < V; ++v) if (g->deg[v] > maxdeg) maxdeg = g->deg[v];
+    int *bin  = calloc((size_t)maxdeg + 2, sizeof(int));
+    int *rank = malloc((size_t)V * sizeof(int));
+    int *inv  = malloc((size_t)V * sizeof(int));
+    int *nb   = malloc(((size_t)maxdeg + 1) * sizeof(int));
+    if (!bin || !rank || !inv || !nb) { perror("malloc"); exit(1); }
+    for (int v = 0; v < V; ++v) bin[g->deg[v] + 1]++;
+    for (int d = 0; d <= maxdeg; ++d) bin[d + 1] += bin[d];
+    for (int v = 0; v < V; ++v) { rank[v] = bin[g->deg[v]]++; inv[rank[v]] = v; }
+
+    TriJob J = { V, 0, NULL, NULL, NULL, inv, per_vertex, 0 };
+    uint64_t *rows = NULL;
+    int *off = NULL, *out = NULL;
+    size_t rows_bytes = 0;
+    int rows_mapped = 0;
+    if (!g->csr) {
+        J.W = (V + 63) / 64;
+        rows_bytes = (size_t)V * J.W * sizeof(uint64_t);
+        rows = arena_alloc(rows_bytes, &rows_mapped);
+        for (int v = 0; v < V; ++v) {
+            uint64_t *row = rows + (size_t)rank[v] * J.W;
+            int n = neighbours(g, v, nb);
+            for (int j = 0; j < n; ++j) row[rank[nb[j]] >> 6] |= UINT64_C(1) << (rank[nb[j]] & 63);
+        }
+        J.rows = rows;
+    } else {
+        off = calloc((size_t)V + 1, sizeof(int));
+        out = malloc(((size_t)g->E + 1) * sizeof(int));
+        if (!off || !out) { perror("malloc"); exit(1); }
+        for (int v = 0; v < V; ++v)
+            for (int a = g->off[v]; a < g->off[v + 1]; ++a)
+                if (rank[g->nbr[a]] > rank[v]) off[rank[v] + 1]++;
+        for (int r = 0; r < V; ++r) off[r + 1] += off[r];
+        for (int r = 0; r < V; ++r) {
+            int v = inv[r], k = off[r];
+            for (int a = g->off[v]; a < g->off[v + 1]; ++a)
+                if (rank[g->nbr[a]] > r) out[k++] = rank[g->nbr[a]];
+        }
+        J.off = off; J.out = out;
+    }
 
-    NBMasks nb = nb_build(g);
+    if (nthreads < 1) nthreads = 1;
+    if (nthreads > V / TRI_CHUNK + 1) nthreads = V / TRI_CHUNK + 1;
+    TriSlice *sl = calloc((size_t)nthreads, sizeof(TriSlice));
+    pthread_t *tid = malloc((size_t)nthreads * sizeof(pthread_t));
+    if (!sl || !tid) { perror("malloc"); exit(1); }
+    void *(*fn)(void*) = g->csr ? tri_csr_main : tri_dense_main;
+    for (int t = 0; t < nthreads; ++t) {
+        sl[t].job = &J;
+        if (t > 0 && pthread_create(&tid[t], NULL, fn, &sl[t]) != 0) { perror("pthread_create"); exit(1); }
+    }
+    fn(&sl[0]);
+    for (int t = 1; t < nthreads; ++t) pthread_join(tid[t], NULL);
 
-    Bitset R = bs_make(V);
-    Bitset P = bs_make(V);
-    for (int v = 0; v < V; ++v) bs_set(&P, v);
+    long long total = 0;
+    if (per_vertex && !g->csr) {
+        for (int v = 0; v < V; ++v) total += per_vertex[v];
+        total /= 3;
+    } else {
+        for (int t = 0; t < nthreads; ++t) total += sl[t].count;
+    }
 
-    long long cnt = 0;
-    BK_count_all(&R, 0, &P, &nb, &cnt);
+    if (rows) arena_free(rows, rows_bytes, rows_mapped);
+    free(off); free(out); free(sl); free(tid);
+    free(bin); free(rank); free(inv); free(nb);
+    return total;
+}
 
-    bs_free(&R);
-    bs_free(&P);
-    nb_free(&nb);
-    return cnt;
+
+/* Fixed-k clique counting. Each clique is counted once, at its earliest
+   vertex in degeneracy order, inside the local graph of that root's later
+   neighbours (at most degen of them). Below the root the search extends
+   cliques in increasing local id, stops at depth k, and drops any
+   candidate set smaller than the number of vertices still needed. The
+   last two levels are closed form: |P| for one more vertex, the edges
+   inside P for two. The total is bounded by the work done, so unlike the
+   pivoting counter it cannot overflow 128 bits. */
+typedef struct {
+    const Graph *g;
+    const int *order, *pos;
+    int k, degen, maxdeg;
+    int next;               /* shared cursor over roots */
+} KCJob;
+
+typedef struct { KCJob *job; unsigned __int128 count; } KCSlice;
+
+#define KCLQ_CHUNK 16
+
+static unsigned __int128 kc_recurse(const Bitset *LN, const BKScratch *sc, int depth, int need){
+    Bitset P = bk_slot(sc, depth, 0);
+    int size = bs_count(&P);
+    if (size < need) return 0;
+    if (need == 1) return (unsigned __int128)size;
+
+    unsigned __int128 c = 0;
+    if (need == 2) {
+        for (int word = 0; word < P.nwords; ++word)
+            for (uint64_t m = P.w[word]; m; m &= m - 1)
+                c += (unsigned)bs_and_count(&P, &LN[(word << 6) + __builtin_ctzll(m)]);
+        return c / 2;
+    }
+    Bitset Pp = bk_slot(sc, depth + 1, 0);
+    for (int word = 0; word < P.nwords; ++word)
+        for (uint64_t m = P.w[word]; m && size >= need; m &= m - 1, --size) {
+            int x = (word << 6) + __builtin_ctzll(m);
+            bs_and_into(&Pp, &P, &LN[x]);
+            c += kc_recurse(LN, sc, depth + 1, need - 1);
+            bs_clear(&P, x);
+        }
+    return c;
+}
+
+static void* kc_worker_main(void *arg){
+    KCSlice *sl = arg;
+    KCJob *J = sl->job;
+    const int V = J->g->V, degen = J->degen, need = J->k - 1;
+    int *nb = malloc(((size_t)J->maxdeg + 1) * sizeof(int));
+    int *loc = malloc(((size_t)V + 1) * sizeof(int));
+    Bitset *LN = malloc(((size_t)degen + 1) * sizeof(Bitset));
+    BKScratch sc;
+    sc.nbits = degen;
+    sc.nwords = (degen + 63) / 64;
+    sc.per = 1;
+    sc.slab = calloc((size_t)(J->k + 1) * sc.nwords + 1, sizeof(uint64_t));
+    if (!nb || !loc || !LN || !sc.slab) { perror("malloc"); exit(1); }
+    for (int v = 0; v < V; ++v) loc[v] = -1;
+    for (int i = 0; i < degen; ++i) LN[i] = bs_make(degen);
+
+    for (;;) {
+        int i0 = __atomic_fetch_add(&J->next, KCLQ_CHUNK, __ATOMIC_RELAXED);
+        if (i0 >= V) break;
+        int i1 = i0 + KCLQ_CHUNK < V ? i0 + KCLQ_CHUNK : V;
+        for (int i = i0; i < i1; ++i) {
+            if (J->g->deg[J->order[i]] < need) continue;
+            int n = later_nbhood(J->g, J->order, J->pos, i, nb, loc, LN);
+            if (n < need) continue;
+            /* a member of a local (k-1)-clique has k-2 local neighbours */
+            Bitset P = bk_slot(&sc, 0, 0);
+            P.nbits = n;
+            bs_zero(&P);
+            for (int a = 0; a < n; ++a) if (bs_count(&LN[a]) >= need - 1) bs_set(&P, a);
+            sl->count += kc_recurse(LN, &sc, 0, need);
+        }
+    }
+
+    for (int i = 0; i < degen; ++i) bs_free(&LN[i]);
+    free(LN); free(sc.slab); free(nb); free(loc);
+    return NULL;
+}
+
+unsigned __int128 count_kcliques(const Graph *g, int k, int nthreads)
+{
+    const int V = g->V;
+    if (k < 1 || V < k) return 0;
+    if (k == 1) return (unsigned __int128)V;
+    if (k == 2) return (unsigned __int128)g->E;
+    if (k == 3) return (unsigned __int128)count_triangles(g, nthreads, NULL);
+    csr_require(g);
+
+    int *order = malloc(((size_t)V + 1) * sizeof(int));
+    int *pos   = malloc(((size_t)V + 1) * sizeof(int));
+    if (!order || !pos) { perror("malloc"); exit(1); }
+    int degen = degeneracy_order(g, order, NULL);
+    if (k > degen + 1) { free(order); free(pos); return 0; }
+    for (int i = 0; i < V; ++i) pos[order[i]] = i;
+
+    KCJob J = { g, order, pos, k, degen, 0, 0 };
+    for (int v = 0; v < V; ++v) if (g->deg[v] > J.maxdeg) J.maxdeg = g->deg[v];
+
+    if (nthreads < 1) nthreads = 1;
+    if (nthreads > V / KCLQ_CHUNK + 1) nthreads = V / KCLQ_CHUNK + 1;
+    KCSlice *sl = calloc((size_t)nthreads, sizeof(KCSlice));
+    pthread_t *tid = malloc((size_t)nthreads * sizeof(pthread_t));
+    if (!sl || !tid) { perror("malloc"); exit(1); }
+    for (int t = 0; t < nthreads; ++t) {
+        sl[t].job = &J;
+        if (t > 0 && pthread_create(&tid[t], NULL, kc_worker_main, &sl[t]) != 0) { perror("pthread_create"); exit(1); }
+    }
+    kc_worker_main(&sl[0]);
+    for (int t = 1; t < nthreads; ++t) pthread_join(tid[t], NULL);
+
+    unsigned __int128 total = 0;
+    for (int t = 0; t < nthreads; ++t) total += sl[t].count;
+    free(sl); free(tid); free(order); free(pos);
+    return total;
+}
+
+/* Maximum clique for large sparse graphs. A clique's earliest vertex v in
+   degeneracy order has the rest of it among v's later neighbours, at most
+   degen of them, so each root is solved by BB_expand on local bitsets of
+   that width: O(E + degen^2) memory instead of the V-bit rows of
+   max_clique_bb. Roots are taken from the densest end of the order, and a
+   root whose core number (its later-neighbourhood size) cannot beat the
+   incumbent is skipped without building anything. */
+#define SPMC_CHUNK 8
+
+typedef struct {
+    const Graph *g;
+    const int *order, *pos, *core;
+    int degen, maxdeg;
+    int next;           /* roots handed out so far, from the top of the order */
+    int best;           /* incumbent size, shared */
+} SPMCJob;
+
+typedef struct {
+    SPMCJob *job;
+    int *nb, *loc, *cand;
+    Bitset *LN;
+    BBState S;          /* local search over LN; sc is resized per root */
+    int best, *best_C;  /* largest clique this worker found, original ids */
+} SPMCWorker;
+
+static void spmc_worker_make(SPMCJob *J, SPMCWorker *w){
+    const int degen = J->degen, nw = (degen + 63) / 64;
+    w->job = J;
+    w->best = 0;
+    w->nb   = malloc(((size_t)J->maxdeg + 1) * sizeof(int));
+    w->loc  = malloc(((size_t)J->g->V + 1) * sizeof(int));
+    w->cand = malloc(((size_t)degen + 2) * sizeof(int));
+    w->best_C = malloc(((size_t)degen + 2) * sizeof(int));
+    w->LN   = malloc(((size_t)degen + 1) * sizeof(Bitset));
+    if (!w->nb || !w->loc || !w->cand || !w->best_C || !w->LN) { perror("malloc"); exit(1); }
+    for (int v = 0; v < J->g->V; ++v) w->loc[v] = -1;
+    for (int i = 0; i < degen; ++i) w->LN[i] = bs_make(degen);
+
+    BBState *S = &w->S;
+    S->best_size = 0;
+    S->shared_best = NULL;
+    S->N = w->LN;
+    S->sc.nbits = degen;
+    S->sc.nwords = nw;
+    S->sc.per = 3;
+    S->sc.slab = calloc((size_t)(degen + 3) * 3 * nw + 1, sizeof(uint64_t));
+    S->V = degen;
+    S->lcap = degen;
+    const size_t lsz = bb_list_off(S, degen + 2) + 1;
+    S->list = malloc(lsz * sizeof(int));
+    S->col  = malloc(lsz * sizeof(int));
+    S->C      = malloc(((size_t)degen + 2) * sizeof(int));
+    S->best_C = malloc(((size_t)degen + 2) * sizeof(int));
+    if (!S->sc.slab || !S->list || !S->col || !S->C || !S->best_C) { perror("malloc"); exit(1); }
+}
+
+static void spmc_worker_free(SPMCWorker *w){
+    for (int i = 0; i < w->job->degen; ++i) bs_free(&w->LN[i]);
+    free(w->LN); free(w->nb); free(w->loc); free(w->cand); free(w->best_C);
+    bb_state_free(&w->S);
+}
+
+/* Looks for a clique larger than floor (>= 1) whose earliest vertex is
+   order[i]. Returns its size with the vertices in w->cand, or 0. */
+static int spmc_root(SPMCWorker *w, int i, int floor){
+    SPMCJob *J = w->job;
+    if (J->core[J->order[i]] + 1 <= floor) return 0;
+    int k = later_nbhood(J->g, J->order, J->pos, i, w->nb, w->loc, w->LN);
+
+    /* slots only need k bits for this root */
+    BBState *S = &w->S;
+    S->sc.nbits = k;
+    S->sc.nwords = (k + 63) / 64;
+    /* a member of a local clique of size floor has floor - 1 local
+       neighbours; the test only skips roots, so that the search itself,
+       and the clique it finds, do not depend on floor */
+    int fit = 0;
+    for (int a = 0; a < k; ++a) fit += bs_count(&w->LN[a]) >= floor - 1;
+    if (fit < floor) return 0;
+    Bitset P = bk_slot(&S->sc, 0, 0);
+    bs_zero(&P);
+    for (int a = 0; a < k; ++a) bs_set(&P, a);
+
+    S->best_size = floor - 1;
+    BB_expand(0, S);
+    if (S->best_size <= floor - 1) return 0;
+    w->cand[0] = J->order[i];
+    for (int j = 0; j < S->best_size; ++j) w->cand[j + 1] = w->nb[S->best_C[j]];
+    return S->best_size + 1;
+}
+
+static void* spmc_worker_main(void *arg){
+    SPMCWorker *w = arg;
+    SPMCJob *J = w->job;
+    const int V = J->g->V;
+    for (;;) {
+        int r0 = __atomic_fetch_add(&J->next, SPMC_CHUNK, __ATOMIC_RELAXED);
+        if (r0 >= V) break;
+        int r1 = r0 + SPMC_CHUNK < V ? r0 + SPMC_CHUNK : V;
+        for (int r = r0; r < r1; ++r) {
+            int size = spmc_root(w, V - 1 - r, __atomic_load_n(&J->best, __ATOMIC_RELAXED));
+            if (!size) continue;
+            w->best = size;
+            memcpy(w->best_C, w->cand, (size_t)size * sizeof(int));
+            int cur = __atomic_load_n(&J->best, __ATOMIC_RELAXED);
+            while (size > cur &&
+                   !__atomic_compare_exchange_n(&J->best, &cur, size, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                ;
+        }
+    }
+    return NULL;
 }
 
+int max_clique_sparse(const Graph *g, int nthreads, int *clique_out, int *clique_size_out){
+    const int V = g->V;
+    if (V == 0) { if (clique_size_out) *clique_size_out = 0; return 0; }
+    csr_require(g);
+
+    int *order = malloc((size_t)V * sizeof(int));
+    int *pos   = malloc((size_t)V * sizeof(int));
+    int *core  = malloc((size_t)V * sizeof(int));
+    if (!order || !pos || !core) { perror("malloc"); exit(1); }
+    SPMCJob J = { g, order, pos, core, degeneracy_order(g, order, core), 0, 0, 1 };
+    for (int i = 0; i < V; ++i) pos[order[i]] = i;
+    for (int v = 0; v < V; ++v) if (g->deg[v] > J.maxdeg) J.maxdeg = g->deg[v];
+
+    if (nthreads < 1) nthreads = 1;
+    if (nthreads > V / SPMC_CHUNK + 1) nthreads = V / SPMC_CHUNK + 1;
+    SPMCWorker *w = malloc((size_t)nthreads * sizeof(SPMCWorker));
+    pthread_t *tid = malloc((size_t)nthreads * sizeof(pthread_t));
+    if (!w || !tid) { perror("malloc"); exit(1); }
+    for (int t = 0; t < nthreads; ++t) {
+        spmc_worker_make(&J, &w[t]);
+        if (t > 0 && pthread_create(&tid[t], NULL, spmc_worker_main, &w[t]) != 0) { perror("pthread_create"); exit(1); }
+    }
+    spmc_worker_main(&w[0]);
+    for (int t = 1; t < nthreads; ++t) pthread_join(tid[t], NULL);
+
+    /* Sequentially, the witness is the first root in order that holds a
+       clique of size omega (any floor below omega finds the same one), so
+       with several workers that root is searched for again. */
+    const int best = J.best;
+    int *wit = w[0].best_C;
+    if (best == 1) {
+        wit[0] = 0;                    /* no edges: vertex 0, as the dense engines report */
+    } else if (nthreads > 1) {
+        for (int r = 0; r < V; ++r)
+            if (spmc_root(&w[0], V - 1 - r, best - 1)) { wit = w[0].cand; break; }
+    }
+    qsort(wit, (size_t)best, sizeof(int), cmp_int);
+    if (clique_out) memcpy(clique_out, wit, (size_t)best * sizeof(int));
+    if (clique_size_out) *clique_size_out = best;
+
+    for (int t = 0; t < nthreads; ++t) spmc_worker_free(&w[t]);
+    free(w); free(tid); free(order); free(pos); free(core);
+    return best;
+}
 
-static int ham_backtrack(const Graph *g, int start, int pos, int *path, unsigned char *used) {
-    if (pos == g->V) {
-        int last = path[g->V - 1];
-        return g->adj[last][start] ? 1 : 0;  // close the cycle
+
+/* Approximate clique counting (Knuth's search-tree estimator). Orient
+   every edge along the degeneracy order; the cliques are then the nodes of
+   a tree whose depth-k nodes are the k-cliques listed in increasing rank,
+   and a node with candidate set P has exactly |P| children. One sample
+   walks down from a uniform root, picking a uniform child at each level;
+   the product of the branching factors seen so far is an unbiased estimate
+   of the node count at every depth. A walk costs O(degen) per level, so
+   the run time follows the number of samples, not the number of cliques.
+   Samples are drawn in blocks of APPROX_BLOCK with counter-based streams
+   and folded in block order, so the result depends on the seed only. */
+#define APPROX_BLOCK 256
+#define APPROX_FIRST_BATCH 4096
+#define APPROX_ZERO_SAMPLES 65536   /* an estimate still 0 after this many samples is final */
+#define APPROX_MIN_WEIGHT 1e-12     /* floor on a root weight, relative to the heaviest root */
+#define APPROX_LOG_CAP 575.0        /* child weights stay below e^575 ~ 1e250 */
+
+typedef struct {
+    int V, kmin, kmax;
+    const int *off, *out;   /* later neighbours by rank, ascending */
+    const double *cum;      /* root r is drawn with probability cum[r+1] - cum[r] */
+    const double *sw;       /* child weights once kmin is reached, by rank */
+    const double *lf;       /* lf[i] = log(i!), i <= degen */
+    uint64_t key;
+    long long b0, b1;       /* blocks of this batch */
+    long long next;         /* shared cursor over blocks */
+    double *sum, *sumsq;    /* per block, indexed from b0 */
+} ApproxJob;
+
+static inline int rng_below(uint64_t *st, int n) {
+    return (int)(((unsigned __int128)rng_next(st) * (unsigned)n) >> 64);
+}
+
+static double approx_walk(const ApproxJob *J, uint64_t *st, int *cand, int *tmp, double *w) {
+    double u = rng_unit(st) * J->cum[J->V];
+    int lo = 0, hi = J->V - 1;
+    while (lo < hi) { int mid = (lo + hi) / 2; if (J->cum[mid + 1] < u) lo = mid + 1; else hi = mid; }
+    int r = lo, n = J->off[r + 1] - J->off[r];
+    double f = J->cum[J->V] / (J->cum[r + 1] - J->cum[r]), y = (J->kmin <= 1) ? f : 0.0;
+    memcpy(cand, J->out + J->off[r], (size_t)n * sizeof(int));
+    for (int d = 1; n > 0 && (J->kmax == 0 || d < J->kmax); ++d) {
+        if (d + 1 >= J->kmin) y += f * n;
+        /* Below kmin, child i is weighted by the number of ways to pick the
+           vertices still needed from the at most min(later degree, n-1-i)
+           candidates it keeps; a child that cannot reach kmin gets 0. */
+        int need = J->kmin - d - 1;
+        double tot = 0, lmax = -INFINITY;
+        for (int i = 0; i < n; ++i) {
+            if (need <= 0) { w[i] = J->sw[cand[i]]; tot += w[i]; continue; }
+            int m = J->off[cand[i] + 1] - J->off[cand[i]];
+            if (m > n - 1 - i) m = n - 1 - i;
+            w[i] = m < need ? -INFINITY : J->lf[m] - J->lf[need] - J->lf[m - need];
+            if (w[i] > lmax) lmax = w[i];
+        }
+        if (need > 0) {
+            if (lmax == -INFINITY) break;
+            for (int i = 0; i < n; ++i) { w[i] = exp(w[i] - lmax); tot += w[i]; }
+        }
+        double v = rng_unit(st) * tot, acc = 0;
+        int i = 0, last = 0;
+        for (; i < n; ++i) {
+            if (w[i] == 0) continue;
+            last = i;
+            if ((acc += w[i]) >= v) break;
+        }
+        if (i == n) i = last;
+        int x = cand[i], m = 0;
+        f *= tot / w[i];
+        const int *a = J->out + J->off[x], *e = J->out + J->off[x + 1];
+        for (int c = 0; c < n && a < e; ) {
+            if      (cand[c] < *a) ++c;
+            else if (cand[c] > *a) ++a;
+            else { tmp[m++] = cand[c]; ++c; ++a; }
+        }
+        int *t = cand; cand = tmp; tmp = t;
+        n = m;
+    }
+    return y;
+}
+
+typedef struct { ApproxJob *job; int *cand, *tmp; double *w; } ApproxWorker;
+
+static void* approx_worker_main(void *arg) {
+    ApproxWorker *w = arg;
+    ApproxJob *J = w->job;
+    for (;;) {
+        long long b = __atomic_fetch_add(&J->next, 1, __ATOMIC_RELAXED);
+        if (b >= J->b1) break;
+        double s = 0, s2 = 0;
+        for (long long i = b * APPROX_BLOCK; i < (b + 1) * APPROX_BLOCK; ++i) {
+            uint64_t st = cb_rand(J->key, (uint64_t)i);
+            double y = approx_walk(J, &st, w->cand, w->tmp, w->w);
+            s += y; s2 += y * y;
+        }
+        J->sum[b - J->b0] = s;
+        J->sumsq[b - J->b0] = s2;
+    }
+    return NULL;
+}
+
+/* Log of the expected number of cliques with kmin..kmax vertices (kmax = 0:
+   any) that contain a root with m later neighbours, if those neighbours
+   were joined independently with probability p; -INFINITY if there are
+   none. Used as the root's sampling weight. Summed in log space, since for
+   large kmin the weight itself is far below the smallest double. */
+static double approx_root_logw(int m, double p, int kmin, int kmax) {
+    int j0 = kmin > 1 ? kmin - 1 : 0, j1 = (kmax > 0 && kmax - 1 < m) ? kmax - 1 : m;
+    double lw = -INFINITY;
+    for (int j = j0; j <= j1; ++j) {
+        if (j >= 2 && p <= 0.0) break;
+        double lt = lgamma(m + 1.0) - lgamma(j + 1.0) - lgamma(m - j + 1.0);
+        if (j >= 2) lt += 0.5 * j * (j - 1) * log(p);
+        lw = lt > lw ? lt + log1p(exp(lw - lt)) : lw + log1p(exp(lt - lw));
+    }
+    return lw;
+}
+
+/* z with P(|N(0,1)| <= z) = confidence, by bisection on erf. */
+static double normal_quantile(double confidence) {
+    double lo = 0.0, hi = 40.0;
+    for (int it = 0; it < 100; ++it) {
+        double mid = 0.5 * (lo + hi);
+        if (erf(mid / sqrt(2.0)) < confidence) lo = mid; else hi = mid;
+    }
+    return hi;
+}
+
+int approx_count_cliques(const Graph *g, int kmin, int kmax, double rel_err, double confidence,
+                         long long max_samples, unsigned int seed, int nthreads, CountEstimate *est)
+{
+    const int V = g->V;
+    memset(est, 0, sizeof(*est));
+    if (kmin < 1) kmin = 1;
+    if (V == 0 || (kmax > 0 && kmax < kmin)) return 1;
+    csr_require(g);
+
+    int *order = malloc(((size_t)V + 1) * sizeof(int));
+    int *pos   = malloc(((size_t)V + 1) * sizeof(int));
+    int *off   = calloc((size_t)V + 1, sizeof(int));
+    int *out   = malloc(((size_t)g->E + 1) * sizeof(int));
+    int *nb    = malloc(((size_t)V + 1) * sizeof(int));
+    if (!order || !pos || !off || !out || !nb) { perror("malloc"); exit(1); }
+    int degen = degeneracy_order(g, order, NULL);
+    if (kmin > degen + 1) { free(order); free(pos); free(off); free(out); free(nb); return 1; }
+    for (int i = 0; i < V; ++i) pos[order[i]] = i;
+    for (int r = 0; r < V; ++r) {
+        int n = neighbours(g, order[r], nb), k = off[r];
+        for (int j = 0; j < n; ++j) if (pos[nb[j]] > r) out[k++] = pos[nb[j]];
+        qsort(out + off[r], (size_t)(k - off[r]), sizeof(int), cmp_int);
+        off[r + 1] = k;
+    }
+    free(nb);
+
+    /* p: edge density among later neighbours, over all roots */
+    double pairs = 0;
+    for (int r = 0; r < V; ++r) pairs += 0.5 * (double)(off[r + 1] - off[r]) * (off[r + 1] - off[r] - 1);
+    long long tri = count_triangles(g, nthreads, NULL);
+    double p = pairs > 0 ? (double)tri / pairs : 0.0;
+    double *cum = malloc(((size_t)V + 1) * sizeof(double));
+    double *sw  = malloc(((size_t)V + 1) * sizeof(double));
+    if (!cum || !sw) { perror("malloc"); exit(1); }
+    /* Root weights relative to the heaviest root. A root that can hold a
+       kmin-clique keeps at least APPROX_MIN_WEIGHT of it, so a structure
+       the density model misjudges is still sampled. Child weights include
+       the empty clique, so they are >= 1 and only need capping. */
+    double lmax = -INFINITY;
+    for (int r = 0; r < V; ++r) {
+        cum[r + 1] = approx_root_logw(off[r + 1] - off[r], p, kmin, kmax);
+        if (cum[r + 1] > lmax) lmax = cum[r + 1];
+        double ls = approx_root_logw(off[r + 1] - off[r], p, 1, kmax);
+        sw[r] = ls < APPROX_LOG_CAP ? exp(ls) : exp(APPROX_LOG_CAP);
+    }
+    cum[0] = 0;
+    for (int r = 0; r < V; ++r) {
+        double w = cum[r + 1] > -INFINITY ? exp(cum[r + 1] - lmax) : 0.0;
+        if (off[r + 1] - off[r] + 1 >= kmin && w < APPROX_MIN_WEIGHT) w = APPROX_MIN_WEIGHT;
+        cum[r + 1] = cum[r] + w;
+    }
+
+    double *lf = malloc(((size_t)degen + 1) * sizeof(double));
+    if (!lf) { perror("malloc"); exit(1); }
+    for (int i = 0; i <= degen; ++i) lf[i] = lgamma(i + 1.0);
+
+    ApproxJob J;
+    memset(&J, 0, sizeof(J));
+    J.V = V; J.kmin = kmin; J.kmax = kmax;
+    J.off = off; J.out = out; J.cum = cum; J.sw = sw; J.lf = lf;
+    J.key = mix64((uint64_t)seed ^ UINT64_C(0x436c697175657321));
+
+    if (nthreads < 1) nthreads = 1;
+    ApproxWorker *w = calloc((size_t)nthreads, sizeof(ApproxWorker));
+    pthread_t *tid = malloc((size_t)nthreads * sizeof(pthread_t));
+    if (!w || !tid) { perror("malloc"); exit(1); }
+    for (int t = 0; t < nthreads; ++t) {
+        w[t].job = &J;
+        w[t].cand = malloc(((size_t)degen + 1) * sizeof(int));
+        w[t].tmp  = malloc(((size_t)degen + 1) * sizeof(int));
+        w[t].w    = malloc(((size_t)degen + 1) * sizeof(double));
+        if (!w[t].cand || !w[t].tmp || !w[t].w) { perror("malloc"); exit(1); }
+    }
+
+    const double z = normal_quantile(confidence);
+    const long long max_blocks = (max_samples + APPROX_BLOCK - 1) / APPROX_BLOCK;
+    long long done = 0, want = APPROX_FIRST_BATCH / APPROX_BLOCK;
+    double s = 0, s2 = 0, mean = 0, half = 0;
+    int met = 0;
+    while (done < max_blocks) {
+        if (want > max_blocks - done) want = max_blocks - done;
+        J.b0 = J.next = done; J.b1 = done + want;
+        J.sum = malloc((size_t)want * sizeof(double));
+        J.sumsq = malloc((size_t)want * sizeof(double));
+        if (!J.sum || !J.sumsq) { perror("malloc"); exit(1); }
+        int nt = nthreads < want ? nthreads : (int)want;
+        for (int t = 1; t < nt; ++t)
+            if (pthread_create(&tid[t], NULL, approx_worker_main, &w[t]) != 0) { perror("pthread_create"); exit(1); }
+        approx_worker_main(&w[0]);
+        for (int t = 1; t < nt; ++t) pthread_join(tid[t], NULL);
+        for (long long b = 0; b < want; ++b) { s += J.sum[b]; s2 += J.sumsq[b]; }
+        free(J.sum); free(J.sumsq);
+        done += want;
+
+        double n = (double)(done * APPROX_BLOCK);
+        mean = s / n;
+        double var = (s2 - s * mean) / (n - 1);
+        half = z * sqrt(var > 0 ? var / n : 0);
+        if (mean > 0 && half <= rel_err * mean) { met = 1; break; }
+        if (s2 == 0 && n >= APPROX_ZERO_SAMPLES) { met = 1; break; }
+        /* samples the normal interval says are still needed, plus 10% */
+        double need = (mean > 0) ? 1.1 * (z * z * var) / (rel_err * rel_err * mean * mean) - n : n;
+        if (need < n / 4) need = n / 4;
+        if (need > n * 8) need = n * 8;
+        want = (long long)ceil(need / APPROX_BLOCK);
+    }
+
+    est->estimate = mean;
+    est->lo = mean - half > 0 ? mean - half : 0;
+    est->hi = mean + half;
+    est->samples = done * APPROX_BLOCK;
+    for (int t = 0; t < nthreads; ++t) { free(w[t].cand); free(w[t].tmp); free(w[t].w); }
+    free(w); free(tid); free(order); free(pos); free(off); free(out); free(cum); free(sw); free(lf);
+    return met;
+}
+
+
+/* Neighbour lists of g: the CSR rows themselves, or lists built from the
+   bit rows. Returns 1 if *off and *nbr were allocated here. */
+static int adj_lists(const Graph *g, int **off, int **nbr) {
+    if (g->csr) { *off = g->off; *nbr = g->nbr; return 0; }
+    *off = malloc(((size_t)g->V + 1) * sizeof(int));
+    *nbr = malloc(((size_t)2 * g->E + 1) * sizeof(int));
+    if (!*off || !*nbr) { perror("malloc"); exit(1); }
+    (*off)[0] = 0;
+    for (int v = 0; v < g->V; ++v) (*off)[v + 1] = (*off)[v] + neighbours(g, v, *nbr + (*off)[v]);
+    return 1;
+}
+
+/* Deletes edge slot a of u (and its twin in the other row) from the live
+   adjacency used by graph_reduce_hamilton. */
+static void ham_cut(const int *off, const int *nbr, char *alive, int *d, int u, int a){
+    int w = nbr[a];
+    alive[a] = 0;
+    for (int b = off[w]; b < off[w + 1]; ++b) if (nbr[b] == u && alive[b]) { alive[b] = 0; break; }
+    d[u]--; d[w]--;
+}
+
+int graph_reduce_hamilton(const Graph *g, GraphReduction *r){
+    const int V = g->V;
+    memset(r, 0, sizeof(*r));
+    int *off, *nbr;
+    int owned = adj_lists(g, &off, &nbr);
+    char *alive = malloc((size_t)off[V] + 1);
+    int *d  = malloc(((size_t)V + 1) * sizeof(int));
+    int *nf = calloc((size_t)V + 1, sizeof(int));       /* degree-2 neighbours of a vertex of degree > 2 */
+    int *q2 = malloc(((size_t)V + 1) * sizeof(int));    /* vertices that reached degree 2 */
+    int *qt = malloc(((size_t)V + 1) * sizeof(int));    /* vertices with two forced edges */
+    if (!alive || !d || !nf || !q2 || !qt) { perror("malloc"); exit(1); }
+    memset(alive, 1, (size_t)off[V] + 1);
+    int n2 = 0, nt = 0, rc = 0;
+    for (int v = 0; v < V; ++v) {
+        d[v] = off[v + 1] - off[v];
+        if (d[v] < 2) rc = -1;
+        else if (d[v] == 2) q2[n2++] = v;
+    }
+
+    /* Both edges of a degree-2 vertex are forced. A vertex with two forced
+       edges keeps only those; one with three cannot be on any cycle. */
+    while (rc == 0 && (n2 || nt)) {
+        if (nt) {
+            int w = qt[--nt];
+            if (d[w] == 2) continue;
+            for (int a = off[w]; a < off[w + 1]; ++a) {
+                if (!alive[a] || d[nbr[a]] == 2) continue;
+                int x = nbr[a];
+                ham_cut(off, nbr, alive, d, w, a);
+                if (d[x] < 2) { rc = -1; break; }
+                if (d[x] == 2) q2[n2++] = x;
+            }
+            if (rc == 0 && d[w] != 2) rc = -1;
+            if (rc == 0) q2[n2++] = w;
+            continue;
+        }
+        int v = q2[--n2];
+        for (int a = off[v]; a < off[v + 1]; ++a) {
+            int w = nbr[a];
+            if (!alive[a] || d[w] <= 2) continue;
+            if (++nf[w] > 2) { rc = -1; break; }
+            if (nf[w] == 2) qt[nt++] = w;
+        }
+    }
+
+    /* Anchors are the vertices left with degree > 2 (or two adjacent
+       vertices, if the graph is now a plain cycle) and get reduced ids
+       below na. Every maximal path of degree-2 vertices between two
+       anchors becomes one vertex na + i whose chain is that path. */
+    int *rid   = q2;                                     /* reduced id, reusing q2 */
+    int *runs  = malloc(((size_t)V + 1) * sizeof(int));
+    int *rfrom = malloc(((size_t)V + 1) * sizeof(int));
+    int *roff  = malloc(((size_t)V + 2) * sizeof(int));
+    int *eu    = malloc(((size_t)off[V] / 2 + 2 * (size_t)V + 1) * sizeof(int));
+    int *ev    = malloc(((size_t)off[V] / 2 + 2 * (size_t)V + 1) * sizeof(int));
+    if (!runs || !rfrom || !roff || !eu || !ev) { perror("malloc"); exit(1); }
+    int na = 0, nrun = 0, nrv = 0;
+    long long m = 0;
+    roff[0] = 0;
+    if (rc == 0) {
+        for (int v = 0; v < V; ++v) rid[v] = d[v] > 2 ? na++ : -1;
+        if (na == 0) {
+            int b = -1;
+            for (int a = off[0]; a < off[1] && b < 0; ++a) if (alive[a]) b = nbr[a];
+            rid[0] = na++;
+            rid[b] = na++;
+        }
+        for (int s = 0; s < V && rc == 0; ++s) {
+            if (rid[s] < 0 || rid[s] >= na) continue;
+            for (int a = off[s]; a < off[s + 1] && rc == 0; ++a) {
+                if (!alive[a]) continue;
+                int u = nbr[a];
+                if (rid[u] >= 0 && rid[u] < na) {
+                    if (s < u) { eu[m] = rid[s]; ev[m] = rid[u]; m++; }
+                    continue;
+                }
+                if (rid[u] >= na) continue;              /* walked from its other end */
+                int prev = s, cur = u;
+                while (rid[cur] < 0) {
+                    rid[cur] = na + nrun;
+                    runs[nrv++] = cur;
+                    int nx = -1;
+                    for (int b = off[cur]; b < off[cur + 1] && nx < 0; ++b)
+                        if (alive[b] && nbr[b] != prev) nx = nbr[b];
+                    prev = cur; cur = nx;
+                }
+                if (cur == s) { rc = -1; break; }        /* forced cycle through one anchor */
+                rfrom[nrun] = s;
+                eu[m] = rid[s];    ev[m] = na + nrun; m++;
+                eu[m] = na + nrun; ev[m] = rid[cur];  m++;
+                roff[++nrun] = nrv;
+            }
+        }
+        for (int v = 0; v < V && rc == 0; ++v) if (rid[v] < 0) rc = -1;   /* forced cycle off the anchors */
+    }
+
+    if (rc == 0) {
+        const int n = na + nrun;
+        r->orig       = malloc(((size_t)n + 1) * sizeof(int));
+        r->chain_off  = malloc(((size_t)n + 2) * sizeof(int));
+        r->chain      = malloc(((size_t)V + 1) * sizeof(int));
+        r->chain_from = malloc(((size_t)n + 1) * sizeof(int));
+        if (!r->orig || !r->chain_off || !r->chain || !r->chain_from) { perror("malloc"); exit(1); }
+        for (int v = 0; v < V; ++v)
+            if (rid[v] < na) { r->orig[rid[v]] = v; r->chain[rid[v]] = v; r->chain_from[rid[v]] = -1; }
+        for (int x = 0; x <= na; ++x) r->chain_off[x] = x;
+        memcpy(r->chain + na, runs, (size_t)nrv * sizeof(int));
+        for (int i = 0; i < nrun; ++i) {
+            r->orig[na + i] = runs[roff[i]];
+            r->chain_from[na + i] = rfrom[i];
+            r->chain_off[na + i + 1] = na + roff[i + 1];
+        }
+        /* contracted edges stand for paths, so weights are not carried */
+        r->g = create_graph_sized(n, m);
+        for (long long e = 0; e < m; ++e) graph_add_edge(r->g, eu[e], ev[e], 1);
+        graph_finalize(r->g);
+    }
+
+    free(runs); free(rfrom); free(roff); free(eu); free(ev);
+    free(alive); free(d); free(nf); free(q2); free(qt);
+    if (owned) { free(off); free(nbr); }
+    return rc;
+}
+
+void graph_expand_cycle(const GraphReduction *r, const int *path, int *out){
+    const int n = r->g->V;
+    int k = 0;
+    for (int j = 0; j < n; ++j) {
+        int x = path[j], c0 = r->chain_off[x], c1 = r->chain_off[x + 1];
+        /* a chain's neighbours on the cycle are its two end anchors */
+        if (r->orig[path[(j + n - 1) % n]] == r->chain_from[x] || c1 - c0 == 1)
+            for (int c = c0; c < c1; ++c) out[k++] = r->chain[c];
+        else
+            for (int c = c1 - 1; c >= c0; --c) out[k++] = r->chain[c];
+    }
+}
+
+/* Pruned Hamiltonian search for graphs too large for the subset DP. The
+   path grows from a minimum-degree start. avail[v] counts the neighbours of
+   v in A = unvisited + {current end, start}; an unvisited v needs two of
+   them, so the search backtracks as soon as one drops below 2, and a
+   neighbour of the end with avail 2 is forced to be the next vertex (two
+   such neighbours: dead end). Every step also checks that the unvisited
+   vertices hang together from the new end and touch the start, and that
+   at most one of them depends on the start for its second edge. Children
+   are tried fewest-available-neighbours first (Warnsdorff). */
+typedef struct {
+    int V, start;
+    const int *off, *nbr;       /* neighbour lists */
+    uint64_t *unvis;            /* unvisited set, one bit per vertex */
+    int nunvis;
+    int *avail;
+    unsigned char *snb;         /* snb[v]: v is adjacent to start */
+    int *path;
+    int *cand, ctop;            /* stack of per-level candidate lists */
+    uint64_t *seen;             /* connectivity check scratch */
+    int *queue;
+} HamSearch;
+
+static inline int ham_unvisited(const HamSearch *S, int v) {
+    return (int)((S->unvis[v >> 6] >> (v & 63)) & 1);
+}
+
+/* Unvisited vertices reachable from `end` through unvisited vertices must
+   be all of them, one must touch the start, and no more of them may need
+   the start as one of their last two available neighbours than the start
+   has free edges. */
+static int ham_connected(HamSearch *S, int end) {
+    memset(S->seen, 0, (size_t)((S->V + 63) / 64) * sizeof(uint64_t));
+    int qh = 0, qt = 0, reached = 0, touch = 0, need_start = 0;
+    int start_slots = (end == S->start) ? 2 : 1;    /* free edges left at the start */
+    S->queue[qt++] = end;
+    S->seen[end >> 6] |= UINT64_C(1) << (end & 63);
+    while (qh < qt) {
+        int x = S->queue[qh++];
+        for (int a = S->off[x]; a < S->off[x + 1]; ++a) {
+            int y = S->nbr[a];
+            if (!ham_unvisited(S, y) || ((S->seen[y >> 6] >> (y & 63)) & 1)) continue;
+            S->seen[y >> 6] |= UINT64_C(1) << (y & 63);
+            S->queue[qt++] = y;
+            reached++;
+            if (S->snb[y]) { touch = 1; if (S->avail[y] == 2 && ++need_start > start_slots) return 0; }
+        }
     }
+    return reached == S->nunvis && touch;
+}
 
-    int prev = path[pos - 1];
-    for (int v = 0; v < g->V; ++v) {
-        if (!g->adj[prev][v]) continue;      
-        if (used[v]) continue;               
-        if (degree(g, v) < 2) continue;
+static int ham_search(HamSearch *S, int pos, int cur) {
+    if (S->nunvis == 0) return S->snb[cur];
 
-        used[v] = 1;
-        path[pos] = v;
-        if (ham_backtrack(g, start, pos + 1, path, used)) return 1;
-        used[v] = 0;
+    int *c = S->cand + S->ctop, n = 0, nforced = 0, forced = -1;
+    for (int a = S->off[cur]; a < S->off[cur + 1]; ++a) {
+        int v = S->nbr[a];
+        if (!ham_unvisited(S, v)) continue;
+        c[n++] = v;
+        /* next to the start, avail 2 may also mean "last" */
+        if (S->avail[v] == 2 && cur != S->start) { nforced++; forced = v; }
+    }
+    if (nforced > 1) return 0;
+    if (nforced == 1) { c[0] = forced; n = 1; }
+    for (int i = 1; i < n; ++i) {                   /* fewest available first */
+        int v = c[i], j = i;
+        while (j > 0 && S->avail[c[j - 1]] > S->avail[v]) { c[j] = c[j - 1]; --j; }
+        c[j] = v;
+    }
+    S->ctop += n;
+
+    for (int i = 0; i < n; ++i) {
+        int v = c[i], ok = 1;
+        S->unvis[v >> 6] &= ~(UINT64_C(1) << (v & 63));
+        S->nunvis--;
+        if (cur != S->start)                        /* cur leaves A */
+            for (int a = S->off[cur]; a < S->off[cur + 1]; ++a) {
+                int y = S->nbr[a];
+                if (--S->avail[y] < 2 && ham_unvisited(S, y)) ok = 0;
+            }
+        if (ok && S->nunvis > 0) ok = ham_connected(S, v);
+        S->path[pos] = v;
+        if (ok && ham_search(S, pos + 1, v)) return 1;
+        if (cur != S->start)
+            for (int a = S->off[cur]; a < S->off[cur + 1]; ++a) S->avail[S->nbr[a]]++;
+        S->unvis[v >> 6] |= UINT64_C(1) << (v & 63);
+        S->nunvis++;
     }
+    S->ctop -= n;
     return 0;
 }
 
-int hamilton_cycle(const Graph *g, int **cycle_out, int *cycle_len_out) {
-    if (!g || g->V < 3) return 0;
+/* Fills path[0..V-1] with a Hamiltonian cycle and returns 1, or returns 0. */
+static int ham_pruned(const Graph *g, int *path) {
+    const int V = g->V, W = (V + 63) / 64;
+    HamSearch S;
+    memset(&S, 0, sizeof(S));
+    S.V = V;
+    int *off, *nbr, owned = adj_lists(g, &off, &nbr);
+    S.off = off; S.nbr = nbr;
+    S.unvis = calloc((size_t)W, sizeof(uint64_t));
+    S.seen  = calloc((size_t)W, sizeof(uint64_t));
+    S.avail = malloc((size_t)V * sizeof(int));
+    S.snb   = calloc((size_t)V, 1);
+    S.queue = malloc((size_t)V * sizeof(int));
+    S.cand  = malloc(((size_t)2 * g->E + 1) * sizeof(int));
+    if (!S.unvis || !S.seen || !S.avail || !S.snb || !S.queue || !S.cand) { perror("malloc"); exit(1); }
+    S.path = path;
+
+    S.start = 0;
+    for (int v = 0; v < V; ++v) {
+        S.avail[v] = g->deg[v];
+        S.unvis[v >> 6] |= UINT64_C(1) << (v & 63);
+        if (g->deg[v] < g->deg[S.start]) S.start = v;
+    }
+    for (int a = S.off[S.start]; a < S.off[S.start + 1]; ++a) S.snb[S.nbr[a]] = 1;
+    S.unvis[S.start >> 6] &= ~(UINT64_C(1) << (S.start & 63));
+    S.nunvis = V - 1;
+    path[0] = S.start;
 
-    if (!connected_among_non_isolated(g)) return 0;
-    for (int i = 0; i < g->V; ++i) {
-        if (degree(g, i) < 2) return 0;  
+    int found = ham_connected(&S, S.start) && ham_search(&S, 1, S.start);
+
+    free(S.unvis); free(S.seen); free(S.avail); free(S.snb); free(S.queue); free(S.cand);
+    if (owned) { free(off); free(nbr); }
+    return found;
+}
+
+/* Held-Karp over bitmasks. Vertex 0 starts the cycle and vertex i+1 is
+   bit i of a subset. reach[S] holds, as one word, the ends of the paths
+   that leave 0 and visit exactly S: bit i joins reach[S] when a neighbour
+   of i ends a path over S \ {i}. A layer of k-bit subsets only reads the
+   layer below, so it is split between threads by colex rank, each slice
+   unranking its first subset and stepping with Gosper's hack. */
+#define HAM_DP_MIN_SLICE 4096
+
+typedef struct {
+    const uint32_t *adj;    /* adj[i]: neighbours of bit i, as bits */
+    uint32_t *reach;
+    int k;
+    uint64_t r0, r1;        /* colex ranks of this slice's k-subsets */
+} HamSlice;
+
+static uint64_t ham_binom[33][33];
+static pthread_once_t ham_binom_once = PTHREAD_ONCE_INIT;
+
+static void ham_binom_init(void) {
+    for (int n = 0; n <= 32; ++n) {
+        ham_binom[n][0] = 1;
+        for (int k = 1; k <= n; ++k) ham_binom[n][k] = ham_binom[n - 1][k - 1] + ham_binom[n - 1][k];
     }
+}
 
-    int *path = (int *)malloc((size_t)g->V * sizeof(int));
-    if (!path) { perror("malloc"); exit(1); }
-    unsigned char *used = (unsigned char *)calloc((size_t)g->V, 1);
-    if (!used) { perror("calloc"); exit(1); }
+/* The k-subset of colex rank r. */
+static uint32_t ham_unrank(uint64_t r, int k) {
+    uint32_t S = 0;
+    for (int i = k; i >= 1; --i) {
+        int c = i - 1;
+        while (ham_binom[c + 1][i] <= r) ++c;
+        S |= UINT32_C(1) << c;
+        r -= ham_binom[c][i];
+    }
+    return S;
+}
 
-    int start = 0;                 
-    path[0] = start;
-    used[start] = 1;
+static void* ham_layer_main(void *arg) {
+    HamSlice *sl = arg;
+    uint64_t S = ham_unrank(sl->r0, sl->k);
+    for (uint64_t r = sl->r0; r < sl->r1; ++r) {
+        uint32_t ends = 0;
+        for (uint32_t m = (uint32_t)S; m; m &= m - 1) {
+            int i = __builtin_ctz(m);
+            if (sl->adj[i] & sl->reach[S ^ (UINT64_C(1) << i)]) ends |= UINT32_C(1) << i;
+        }
+        sl->reach[S] = ends;
+        uint64_t t = S | (S - 1);                       /* next k-subset */
+        S = (t + 1) | (((~t & (t + 1)) - 1) >> (__builtin_ctzll(S) + 1));
+    }
+    return NULL;
+}
 
-    int found = ham_backtrack(g, start, 1, path, used);
+/* Fills path[0..V-1] with a Hamiltonian cycle from vertex 0 and returns 1,
+   or returns 0. Needs 3 <= V <= 32. */
+static int ham_dp(const Graph *g, int nthreads, int *path) {
+    const int n = g->V - 1;
+    pthread_once(&ham_binom_once, ham_binom_init);
+    uint32_t adj[32], adj0 = 0;
+    for (int i = 0; i < n; ++i) {
+        adj[i] = 0;
+        for (int j = 0; j < n; ++j) if (j != i && graph_has_edge(g, i + 1, j + 1)) adj[i] |= UINT32_C(1) << j;
+        if (graph_has_edge(g, 0, i + 1)) adj0 |= UINT32_C(1) << i;
+    }
 
-    free(used);
+    int mapped;
+    size_t bytes = ((size_t)1 << n) * sizeof(uint32_t);
+    uint32_t *reach = arena_alloc(bytes, &mapped);
+    for (int i = 0; i < n; ++i) reach[(size_t)1 << i] = adj0 & (UINT32_C(1) << i);
+
+    if (nthreads < 1) nthreads = 1;
+    HamSlice *sl = calloc((size_t)nthreads, sizeof(HamSlice));
+    pthread_t *tid = malloc((size_t)nthreads * sizeof(pthread_t));
+    if (!sl || !tid) { perror("malloc"); exit(1); }
+    for (int k = 2; k <= n; ++k) {
+        uint64_t total = ham_binom[n][k];
+        int nt = (int)(total / HAM_DP_MIN_SLICE < (uint64_t)nthreads ? total / HAM_DP_MIN_SLICE : (uint64_t)nthreads);
+        if (nt < 1) nt = 1;
+        for (int t = 0; t < nt; ++t) {
+            sl[t].adj = adj; sl[t].reach = reach; sl[t].k = k;
+            sl[t].r0 = total * (uint64_t)t / (uint64_t)nt;
+            sl[t].r1 = total * (uint64_t)(t + 1) / (uint64_t)nt;
+            if (t > 0 && pthread_create(&tid[t], NULL, ham_layer_main, &sl[t]) != 0) { perror("pthread_create"); exit(1); }
+        }
+        ham_layer_main(&sl[0]);
+        for (int t = 1; t < nt; ++t) pthread_join(tid[t], NULL);
+    }
+    free(sl); free(tid);
+
+    /* walk back from an end adjacent to 0 */
+    uint32_t S = (UINT32_C(1) << n) - 1;
+    uint32_t cand = reach[S] & adj0;
+    int found = cand != 0;
+    path[0] = 0;
+    for (int pos = n; found && pos >= 1; --pos) {
+        int i = __builtin_ctz(cand);
+        path[pos] = i + 1;
+        S ^= UINT32_C(1) << i;
+        cand = S ? reach[S] & adj[i] : 0;
+    }
+    arena_free(reach, bytes, mapped);
+    return found;
+}
+
+/* Chvatal's condition on the sorted degrees d1 <= ... <= dn: no i < n/2
+   with d_i <= i and d_(n-i) < n-i. It covers Dirac (min degree >= n/2)
+   and Ore (deg u + deg v >= n for non-adjacent u, v) and guarantees a
+   Hamiltonian cycle. Counting sort keeps the test O(V). */
+static int ham_chvatal(const Graph *g) {
+    const int V = g->V;
+    int *cnt = calloc((size_t)V + 1, sizeof(int)), *d = malloc((size_t)V * sizeof(int));
+    if (!cnt || !d) { perror("malloc"); exit(1); }
+    for (int v = 0; v < V; ++v) cnt[g->deg[v]]++;
+    for (int k = 0, i = 0; k <= V; ++k) while (cnt[k]--) d[i++] = k;
+    int ok = 1;
+    for (int i = 1; 2 * i < V && ok; ++i)
+        if (d[i - 1] <= i && d[V - i - 1] < V - i) ok = 0;
+    free(cnt); free(d);
+    return ok;
+}
+
+/* Bondy-Chvatal closure: while some non-adjacent u, v have
+   deg u + deg v >= n, join them. When the closure is complete, any cycle
+   is Hamiltonian in it; the added edges are then removed newest first, and
+   whenever the cycle x1 .. xn uses the removed edge x1 xn, the degree sum
+   that allowed it gives an i with x1 ~ x(i+1) and xi ~ xn, so reversing
+   x(i+1) .. xn yields a cycle without it. Pairs that reach the threshold
+   when a degree grows to d are exactly the non-neighbours of degree n - d,
+   found by AND-ing the row with a per-degree bitset. Fills path[0..V-1]
+   and returns 1, or 0 if the closure is not complete. */
+static int ham_closure(const Graph *g, int *path) {
+    const int V = g->V, W = (V + 63) / 64;
+    uint64_t *rows  = calloc((size_t)V * W, sizeof(uint64_t));
+    uint64_t *bydeg = calloc((size_t)(V + 1) * W, sizeof(uint64_t));
+    int *deg = malloc((size_t)V * sizeof(int)), *nb = malloc((size_t)V * sizeof(int));
+    if (!rows || !bydeg || !deg || !nb) { perror("malloc"); exit(1); }
+#define ROW(v)    (rows + (size_t)(v) * W)
+#define BYDEG(d)  (bydeg + (size_t)(d) * W)
+#define HAS(u, v) ((ROW(u)[(v) >> 6] >> ((v) & 63)) & 1)
+    for (int v = 0; v < V; ++v) {
+        int n = neighbours(g, v, nb);
+        for (int j = 0; j < n; ++j) ROW(v)[nb[j] >> 6] |= UINT64_C(1) << (nb[j] & 63);
+        deg[v] = g->deg[v];
+        BYDEG(deg[v])[v >> 6] |= UINT64_C(1) << (v & 63);
+    }
+
+    /* queue of candidate pairs, then the log of added edges */
+    size_t qcap = 1024, qh = 0, qt = 0, nadd = 0;
+    int (*q)[2] = malloc(qcap * sizeof(*q)), (*added)[2] = NULL;
+    if (!q) { perror("malloc"); exit(1); }
+#define PUSH(a, b) do { \
+        if (qt == qcap) { qcap *= 2; q = realloc(q, qcap * sizeof(*q)); if (!q) { perror("realloc"); exit(1); } } \
+        q[qt][0] = (a); q[qt][1] = (b); qt++; } while (0)
+    for (int u = 0; u < V; ++u)
+        for (int w = u + 1; w < V; ++w)
+            if (!HAS(u, w) && deg[u] + deg[w] >= V) PUSH(u, w);
+    added = malloc((qt > 0 ? qt : 1) * sizeof(*added));
+    size_t acap = qt > 0 ? qt : 1;
+    if (!added) { perror("malloc"); exit(1); }
+
+    while (qh < qt) {
+        int u = q[qh][0], v = q[qh][1];
+        qh++;
+        if (HAS(u, v)) continue;
+        ROW(u)[v >> 6] |= UINT64_C(1) << (v & 63);
+        ROW(v)[u >> 6] |= UINT64_C(1) << (u & 63);
+        if (nadd == acap) { acap *= 2; added = realloc(added, acap * sizeof(*added)); if (!added) { perror("realloc"); exit(1); } }
+        added[nadd][0] = u; added[nadd][1] = v; nadd++;
+        int ends[2] = { u, v };
+        for (int e = 0; e < 2; ++e) {
+            int x = ends[e];
+            BYDEG(deg[x])[x >> 6] &= ~(UINT64_C(1) << (x & 63));
+            deg[x]++;
+            BYDEG(deg[x])[x >> 6] |= UINT64_C(1) << (x & 63);
+            if (V - deg[x] < 0) continue;
+            const uint64_t *b = BYDEG(V - deg[x]);
+            for (int k = 0; k < W; ++k)
+                for (uint64_t m = b[k] & ~ROW(x)[k]; m; m &= m - 1) {
+                    int w = (k << 6) + __builtin_ctzll(m);
+                    if (w != x) PUSH(x, w);
+                }
+        }
+    }
+#undef PUSH
+    free(q); free(bydeg); free(deg);
+
+    int complete = ((long long)g->E + (long long)nadd == (long long)V * (V - 1) / 2);
+    if (complete) {
+        int *pos = malloc((size_t)V * sizeof(int)), *x = nb;
+        if (!pos) { perror("malloc"); exit(1); }
+        for (int v = 0; v < V; ++v) { path[v] = v; pos[v] = v; }
+        while (nadd > 0) {
+            int u = added[nadd - 1][0], v = added[nadd - 1][1];
+            nadd--;
+            ROW(u)[v >> 6] &= ~(UINT64_C(1) << (v & 63));
+            ROW(v)[u >> 6] &= ~(UINT64_C(1) << (u & 63));
+            int dpos = pos[u] - pos[v];
+            if (dpos != 1 && dpos != -1 && dpos != V - 1 && dpos != 1 - V) continue;
+            /* x0 = v .. x(V-1) = u along the cycle, away from u */
+            int step = (path[(pos[v] + 1) % V] == u) ? V - 1 : 1;
+            for (int j = 0; j < V; ++j) x[j] = path[(pos[v] + (size_t)j * step) % V];
+            int i = 1;
+            while (i < V - 2 && !(HAS(x[0], x[i + 1]) && HAS(x[i], x[V - 1]))) ++i;
+            if (i == V - 2) { complete = 0; break; }      /* cannot happen */
+            for (int j = 0; j <= i; ++j) path[j] = x[j];
+            for (int j = i + 1; j < V; ++j) path[j] = x[V - 1 - (j - i - 1)];
+            for (int j = 0; j < V; ++j) pos[path[j]] = j;
+        }
+        free(pos);
+    }
+#undef ROW
+#undef BYDEG
+#undef HAS
+    free(rows); free(added); free(nb);
+    return complete;
+}
+
+/* Structural reasons for having no Hamiltonian cycle, all O(V + E): too few
+   vertices, more than one component, a vertex of degree < 2, a bridge or
+   an articulation point (one iterative Tarjan lowlink DFS), or a bipartite
+   graph with unequal sides (BFS 2-coloring). */
+int hamilton_obstruction(const Graph *g, char *why, size_t cap) {
+    const int V = g->V;
+    if (V < 3) { snprintf(why, cap, "fewer than 3 vertices"); return 1; }
+    if (g->ncomp > 1) { snprintf(why, cap, "graph is disconnected (%d components)", g->ncomp); return 1; }
+    for (int v = 0; v < V; ++v)
+        if (g->deg[v] < 2) { snprintf(why, cap, "vertex %d has degree %d", v, g->deg[v]); return 1; }
+    csr_require(g);
+
+    int *off, *nbr, owned = adj_lists(g, &off, &nbr);
+    int *disc = calloc((size_t)V, sizeof(int));
+    int *low  = malloc((size_t)V * sizeof(int));
+    int *par  = malloc((size_t)V * sizeof(int));
+    int *cur  = malloc((size_t)V * sizeof(int));
+    int *stk  = malloc((size_t)V * sizeof(int));
+    if (!disc || !low || !par || !cur || !stk) { perror("malloc"); exit(1); }
+
+    int t = 0, sp = 0, root_kids = 0, cut = -1, bu = -1, bv = -1;
+    disc[0] = low[0] = ++t; par[0] = -1; cur[0] = off[0]; stk[sp++] = 0;
+    while (sp > 0) {
+        int u = stk[sp - 1];
+        if (cur[u] < off[u + 1]) {
+            int w = nbr[cur[u]++];
+            if (!disc[w]) {
+                disc[w] = low[w] = ++t; par[w] = u; cur[w] = off[w]; stk[sp++] = w;
+                if (u == 0) root_kids++;
+            } else if (w != par[u] && disc[w] < low[u]) {
+                low[u] = disc[w];
+            }
+            continue;
+        }
+        --sp;
+        int p = par[u];
+        if (p < 0) continue;
+        if (low[u] < low[p]) low[p] = low[u];
+        if (low[u] > disc[p] && bu < 0) { bu = p; bv = u; }
+        if (p != 0 && low[u] >= disc[p] && cut < 0) cut = p;
+    }
+    if (cut < 0 && root_kids > 1) cut = 0;
+
+    int rc = 1;
+    if (bu >= 0)       snprintf(why, cap, "edge (%d,%d) is a bridge", bu < bv ? bu : bv, bu < bv ? bv : bu);
+    else if (cut >= 0) snprintf(why, cap, "vertex %d is an articulation point", cut);
+    else {
+        /* reuse disc as colors (-1 unseen) and stk as the BFS queue */
+        int side[2] = { 1, 0 }, qh = 0, qt = 0, bip = 1;
+        for (int v = 0; v < V; ++v) disc[v] = -1;
+        disc[0] = 0; stk[qt++] = 0;
+        while (qh < qt) {
+            int u = stk[qh++];
+            for (int a = off[u]; a < off[u + 1]; ++a) {
+                int w = nbr[a];
+                if (disc[w] < 0) { disc[w] = 1 - disc[u]; side[disc[w]]++; stk[qt++] = w; }
+                else if (disc[w] == disc[u]) bip = 0;
+            }
+        }
+        if (bip && side[0] != side[1])
+            snprintf(why, cap, "bipartite with sides of %d and %d vertices", side[0], side[1]);
+        else
+            rc = 0;
+    }
+
+    free(disc); free(low); free(par); free(cur); free(stk);
+    if (owned) { free(off); free(nbr); }
+    return rc;
+}
 
-    if (!found) { free(path); return 0; }
+/* Pósa rotation-extension: the path p[0..k] grows at its end e while e
+   has an unvisited neighbour, taking the one with the fewest unvisited
+   neighbours of its own (Warnsdorff; the scan starts at a random offset to
+   break ties). If only p[0] can still grow, the path is turned around.
+   Otherwise a neighbour p[i] of e is used to rotate, reversing
+   p[i+1..k] so that p[i+1] becomes the new end; rotations whose new end can
+   extend, or close the cycle once the path is full, are preferred over a
+   random one. Each restart picks a random start and gets HAM_POSA_STEPS(V)
+   steps. Workers draw from their own stream cb_rand(key, tid) and stop
+   when one of them succeeds or the deadline passes. */
+#define HAM_POSA_STEPS(V) (16LL * (V) * (1 + (long long)log2((double)(V))))
 
+typedef struct {
+    const Graph *g;
+    const int *off, *nbr;
+    uint64_t key;
+    int tid;
+    double deadline;
+    int *path, *pos, *free_nb;  /* free_nb[v]: unvisited neighbours of v */
+    char *near0;                /* neighbours of p[0], which rotations keep */
+    int *winner;                /* -1 until a worker closes a cycle */
+} PosaSlice;
+
+static double ham_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+static inline int posa_below(uint64_t *st, int n) {
+    return (int)(((unsigned __int128)rng_next(st) * (unsigned)n) >> 64);
+}
+
+static void *ham_posa_main(void *arg) {
+    PosaSlice *s = (PosaSlice *)arg;
+    const int V = s->g->V, *off = s->off, *nbr = s->nbr;
+    int *p = s->path, *pos = s->pos, *fr = s->free_nb;
+    char *near0 = s->near0;
+    uint64_t st = cb_rand(s->key, (uint64_t)s->tid);
+    const long long limit = HAM_POSA_STEPS(V);
+
+    for (;;) {
+        for (int v = 0; v < V; ++v) { pos[v] = -1; fr[v] = off[v + 1] - off[v]; near0[v] = 0; }
+        int k = 0, w = posa_below(&st, V);
+        p[0] = w; pos[w] = 0;
+        for (int a = off[w]; a < off[w + 1]; ++a) { --fr[nbr[a]]; near0[nbr[a]] = 1; }
+
+        for (long long step = 0; step < limit; ++step) {
+            if ((step & 15) == 0 &&
+                (__atomic_load_n(s->winner, __ATOMIC_RELAXED) >= 0 || ham_now() >= s->deadline))
+                return NULL;
+
+            int e = p[k], d = off[e + 1] - off[e], r = posa_below(&st, d);
+            if (fr[e] > 0) {
+                w = -1;
+                for (int j = 0; j < d; ++j) {
+                    int x = nbr[off[e] + (r + j) % d];
+                    if (pos[x] < 0 && (w < 0 || fr[x] < fr[w])) w = x;
+                }
+                p[++k] = w; pos[w] = k;
+                for (int a = off[w]; a < off[w + 1]; ++a) --fr[nbr[a]];
+                continue;
+            }
+            if (k == V - 1 && near0[e]) {
+                int none = -1;
+                __atomic_compare_exchange_n(s->winner, &none, s->tid, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+                return NULL;
+            }
+
+            /* the other end can still grow: turn the path around */
+            if (fr[p[0]] > 0) {
+                for (int a = off[p[0]]; a < off[p[0] + 1]; ++a) near0[nbr[a]] = 0;
+                for (int lo = 0, hi = k; lo < hi; ++lo, --hi) {
+                    int t = p[lo]; p[lo] = p[hi]; p[hi] = t;
+                    pos[p[lo]] = lo; pos[p[hi]] = hi;
+                }
+                for (int a = off[p[0]]; a < off[p[0] + 1]; ++a) near0[nbr[a]] = 1;
+                continue;
+            }
+
+            /* rotate on a neighbour other than the predecessor */
+            int i = -1;
+            for (int j = 0; j < d && i < 0; ++j) {
+                int q = pos[nbr[off[e] + (r + j) % d]];
+                if (q < k - 1 && (k == V - 1 ? near0[p[q + 1]] : fr[p[q + 1]] > 0)) i = q;
+            }
+            if (i < 0) {
+                int a = posa_below(&st, d);
+                i = pos[nbr[off[e] + a]];
+                if (i == k - 1) i = pos[nbr[off[e] + (a + 1) % d]];
+            }
+            for (int lo = i + 1, hi = k; lo < hi; ++lo, --hi) {
+                int t = p[lo]; p[lo] = p[hi]; p[hi] = t;
+                pos[p[lo]] = lo; pos[p[hi]] = hi;
+            }
+        }
+    }
+}
+
+/* Checks that path is a permutation of the vertices and that consecutive
+   vertices, including last and first, are adjacent. */
+static int ham_verify(const Graph *g, const int *path) {
+    const int V = g->V;
+    char *seen = calloc((size_t)V, 1);
+    if (!seen) { perror("calloc"); exit(1); }
+    int ok = 1;
+    for (int i = 0; i < V && ok; ++i) {
+        int v = path[i];
+        if (v < 0 || v >= V || seen[v]) ok = 0;
+        else seen[v] = 1;
+    }
+    for (int i = 0; i < V && ok; ++i)
+        if (!graph_has_edge(g, path[i], path[(i + 1) % V])) ok = 0;
+    free(seen);
+    return ok;
+}
+
+/* Hands the cycle out starting and ending at vertex 0. */
+static void ham_report(const Graph *g, const int *path, int **cycle_out, int *cycle_len_out) {
+    int i0 = 0;
+    while (path[i0] != 0) ++i0;
     int *cycle = (int *)malloc((size_t)(g->V + 1) * sizeof(int));
     if (!cycle) { perror("malloc"); exit(1); }
-    for (int i = 0; i < g->V; ++i) cycle[i] = path[i];
-    cycle[g->V] = path[0];
-
-    free(path);
+    for (int i = 0; i < g->V; ++i) cycle[i] = path[(i0 + i) % g->V];
+    cycle[g->V] = 0;
 
     if (cycle_out) *cycle_out = cycle; else free(cycle);
     if (cycle_len_out) *cycle_len_out = g->V + 1;
-    return 1;
+}
+
+int hamilton_posa(const Graph *g, int nthreads, unsigned int seed, double budget_sec,
+                  int **cycle_out, int *cycle_len_out, char *why, size_t cap) {
+    if (!g || hamilton_obstruction(g, why, cap)) return 0;
+    if (nthreads < 1) nthreads = 1;
+
+    GraphReduction r;
+    if (graph_reduce_hamilton(g, &r) < 0) {
+        snprintf(why, cap, "ruled out by the forced edges of degree-2 vertices");
+        return 0;
+    }
+    char sub[128];
+    if (hamilton_obstruction(r.g, sub, sizeof(sub))) {
+        snprintf(why, cap, "after fixing the forced edges of degree-2 vertices, the reduced graph fails a "
+                 "structural check (%s, numbered in the reduced graph)", sub);
+        graph_reduction_free(&r);
+        return 0;
+    }
+    const Graph *h = r.g;
+    const int V = h->V;
+
+    int *off, *nbr;
+    int owned = adj_lists(h, &off, &nbr);
+
+    PosaSlice *sl = calloc((size_t)nthreads, sizeof(PosaSlice));
+    pthread_t *tid = malloc((size_t)nthreads * sizeof(pthread_t));
+    int *buf = malloc((size_t)nthreads * 3 * V * sizeof(int));
+    char *near0 = malloc((size_t)nthreads * V);
+    if (!sl || !tid || !buf || !near0) { perror("malloc"); exit(1); }
+
+    int winner = -1;
+    double deadline = ham_now() + budget_sec;
+    uint64_t key = mix64((uint64_t)seed ^ UINT64_C(0x9a05a1));
+    for (int t = 0; t < nthreads; ++t) {
+        int *mine = buf + (size_t)t * 3 * V;
+        sl[t] = (PosaSlice){ h, off, nbr, key, t, deadline, mine, mine + V, mine + 2 * (size_t)V,
+                             near0 + (size_t)t * V, &winner };
+        if (t > 0 && pthread_create(&tid[t], NULL, ham_posa_main, &sl[t]) != 0) { perror("pthread_create"); exit(1); }
+    }
+    ham_posa_main(&sl[0]);
+    for (int t = 1; t < nthreads; ++t) pthread_join(tid[t], NULL);
+
+    int rc = -1;
+    if (winner >= 0) {
+        int *full = malloc((size_t)g->V * sizeof(int));
+        if (!full) { perror("malloc"); exit(1); }
+        graph_expand_cycle(&r, sl[winner].path, full);
+        if (ham_verify(g, full)) {
+            ham_report(g, full, cycle_out, cycle_len_out);
+            rc = 1;
+        }
+        free(full);
+    }
+
+    free(buf); free(near0); free(tid); free(sl);
+    if (owned) { free(off); free(nbr); }
+    graph_reduction_free(&r);
+    return rc;
+}
+
+int hamilton_cycle(const Graph *g, int **cycle_out, int *cycle_len_out) {
+    return hamilton_cycle_mt(g, 1, cycle_out, cycle_len_out);
+}
+
+int hamilton_cycle_mt(const Graph *g, int nthreads, int **cycle_out, int *cycle_len_out) {
+    if (!g || hamilton_obstruction(g, NULL, 0)) return 0;
+
+    /* the engines run on the reduced graph, which the checks see afresh */
+    GraphReduction r;
+    if (graph_reduce_hamilton(g, &r) < 0) return 0;
+    const Graph *h = r.g;
+    int *path = (int *)malloc((size_t)g->V * sizeof(int));
+    int *full = (int *)malloc((size_t)g->V * sizeof(int));
+    if (!path || !full) { perror("malloc"); exit(1); }
+
+    int found = 0;
+    if (!hamilton_obstruction(h, NULL, 0)) {
+        found = ham_chvatal(h) && ham_closure(h, path);
+        if (!found)
+            found = (h->V <= GRAPH_HAM_DP_MAX_V) ? ham_dp(h, nthreads, path)
+                                                 : ham_pruned(h, path);
+    }
+
+    if (found) {
+        graph_expand_cycle(&r, path, full);
+        ham_report(g, full, cycle_out, cycle_len_out);
+    }
+    free(path); free(full);
+    graph_reduction_free(&r);
+    return found;
 }
 
 #ifndef GRAPH_NO_MAIN
@@ -581,16 +3706,17 @@ int main(int argc, char **argv) {
         return 1;
     }
 
-    Graph *g = create_graph(V);
+    Graph *g = create_graph_sized(V, E);
     generate_random_graph(g, E, seed);
 
     if (printAdj) print_graph(g);
 
-    long long mst = mst_weight_prim(g);
+    int comps = 1;
+    long long mst = mst_weight(g, 1, &comps);
     if (mst >= 0) {
         printf("MST total weight: %lld\n", mst);
     } else {
-        printf("MST: graph is not connected (no spanning tree)\n");
+        printf("MST: graph is not connected (%d components, no spanning tree)\n", comps);
     }
 
     int *cl = malloc(g->V * sizeof(int));
@@ -601,11 +3727,18 @@ int main(int argc, char **argv) {
     for (int i=0;i<cs;i++) printf("%d%s", cl[i], (i+1==cs)?"\n":" ");
     free(cl);
     
-    long long c3 = count_cliques_3plus(g);
-    printf("Number of cliques (sized >= 3): %lld\n", c3);
+    unsigned __int128 c3;
+    char c3s[40];
+    if (count_cliques_3plus_exact(g, &c3) == 0)
+        printf("Number of cliques (sized >= 3): %s\n", u128_to_str(c3, c3s));
+    else
+        printf("Number of cliques (sized >= 3): more than 2^128\n");
 
     int *hc = NULL, hlen = 0;
-    if (hamilton_cycle(g, &hc, &hlen)) {
+    char why[128];
+    if (hamilton_obstruction(g, why, sizeof(why))) {
+      printf("No Hamiltonian cycle: %s.\n", why);
+    } else if (hamilton_cycle(g, &hc, &hlen)) {
     printf("Hamiltonian cycle found: ");
     for (int i = 0; i < hlen; ++i) {
         printf("%d%s", hc[i], (i + 1 == hlen) ? "\n" : " -> ");
@@ -622,8 +3755,7 @@ int main(int argc, char **argv) {
         return 0;
     }
 
-    int oddCount = 0;
-    for (int i = 0; i < g->V; ++i) if (degree(g, i) % 2 != 0) oddCount++;
+    int oddCount = g->odd;
     if (oddCount != 0) {
         printf("No Euler circuit: %d vertices have odd degree.\n", oddCount);
         free_graph(g);
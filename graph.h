@@ -1,23 +1,64 @@
 #pragma once
 #include <stddef.h>
+#include <stdint.h>
 
 typedef struct {
     int V;      
     int E;      
-    int **adj;  
+    uint64_t *bits;     /* dense adjacency: V rows of `words` words, bit v of row u <=> edge (u,v) */
+    int       words;    /* row stride of bits, padded to a cache line */
     int **w;    
+    int       wstride;  /* ints per w row, V padded to a cache line */
+    void  *arena;       /* single block holding bits, the w row table and w rows */
+    size_t arena_bytes;
+    int    arena_mapped;
+
+    /* Compressed-sparse-row storage, used instead of bits/w when csr != 0.
+       graph_add_edge stages edges in (eu,ev,ew); graph_finalize turns them
+       into rows with ascending neighbour ids. */
+    int  csr;
+    int  csr_dirty;     /* edges added since the last graph_finalize */
+    int *off;           /* V+1 row offsets into nbr/nw/eid */
+    int *nbr;           /* 2E neighbour ids */
+    int *nw;            /* 2E weights, parallel to nbr */
+    int *eid;           /* 2E edge ids (index into eu/ev/ew), parallel to nbr */
+    int *eu, *ev, *ew;  /* edge list, E entries */
+    int  ecap;
+    uint64_t *eset;     /* open-addressing set of packed (min,max) keys */
+    size_t    eset_cap;
+
+    /* Maintained by graph_add_edge in both storage modes. */
+    int *deg;           /* degree of each vertex */
+    int  odd;           /* vertices of odd degree */
+    int  isolated;      /* vertices of degree 0 */
+    int *uf, *ufsz;     /* union-find parents and root component sizes */
+    int  ncomp;         /* connected components, isolated vertices included */
 } Graph;
 
 Graph* create_graph(int V);
+/* Sparse graph: memory is O(V + E) instead of O(V^2). */
+Graph* create_graph_csr(int V);
+/* Picks dense or CSR storage for a graph expected to hold about E edges. */
+Graph* create_graph_sized(int V, long long E);
+int    graph_prefers_csr(int V, long long E);
 void   free_graph(Graph *g);
 
 void   generate_random_graph(Graph *g, int targetE, unsigned int seed);
+/* Same graph as generate_random_graph for any nthreads >= 1. */
+void   generate_random_graph_mt(Graph *g, int targetE, unsigned int seed, int nthreads);
 
 
 int    graph_add_edge(Graph *g, int u, int v, int w);
+/* Builds CSR rows after the last graph_add_edge (no-op for dense graphs). */
+void   graph_finalize(Graph *g);
+int    graph_has_edge(const Graph *g, int u, int v);
+int    graph_weight(const Graph *g, int u, int v);
 
 int    degree(const Graph *g, int u);
 int    connected_among_non_isolated(const Graph *g);
+/* Returns the number of connected components and sets comp_of[v] to the
+   component of v; components are numbered by their smallest vertex. */
+int    graph_components(const Graph *g, int *comp_of);
 int    all_even_degrees(const Graph *g);
 
 void   print_graph(const Graph *g);
@@ -25,14 +66,108 @@ void   print_graph(const Graph *g);
 /* Euler circuit (Hierholzer). Returns 1 on success and fills (path,path_len). */
 int    euler_circuit(const Graph *g, int **path_out, int *path_len_out);
 
-/* MST (Prim, O(V^2)). Returns total weight, or -1 if disconnected. */
+/* MST (Prim, O(V^2); heap-based O(E log V) on CSR graphs).
+   Returns total weight, or -1 if disconnected. */
 long long mst_weight_prim(const Graph *g);
+/* Edge-list MST engines. Both return the total weight, or -1 if the graph
+   is disconnected, and store the number of components in *components_out. */
+long long mst_weight_kruskal(const Graph *g, int *components_out);       /* radix sort + union-find */
+long long mst_weight_boruvka(const Graph *g, int nthreads, int *components_out);
+/* Prim for near-complete dense graphs, Borůvka or Kruskal when E << V^2. */
+long long mst_weight(const Graph *g, int nthreads, int *components_out);
+/* Minimum spanning forest: total weight over all components, each solved
+   by mst_weight on its own subgraph, in parallel. comp_weight (optional)
+   gets every component's tree weight, numbered as by graph_components. */
+long long mst_forest(const Graph *g, int nthreads, long long *comp_weight);
 
-/* Max Clique (Bron–Kerbosch with pivot). */
+/* Max Clique (Bron–Kerbosch with pivot). All three engines below solve
+   each connected component on its own and report the largest clique; on
+   CSR graphs they all hand over to max_clique_sparse. */
 int    max_clique(const Graph *g, int *clique_out, int *clique_size_out);
+/* Max Clique by branch and bound with greedy-coloring bounds (MCS/BBMC). */
+int    max_clique_bb(const Graph *g, int *clique_out, int *clique_size_out);
+/* Same search over nthreads workers sharing the incumbent size; reports the
+   same clique as max_clique_bb. */
+int    max_clique_bb_mt(const Graph *g, int nthreads, int *clique_out, int *clique_size_out);
+/* Max Clique for large sparse graphs: each vertex is solved inside its
+   later neighbourhood in degeneracy order with bitsets of degeneracy width,
+   so memory is O(E + degen^2) rather than O(V^2). The reported clique does
+   not depend on nthreads. */
+int    max_clique_sparse(const Graph *g, int nthreads, int *clique_out, int *clique_size_out);
 
-/* Count all cliques of size >= 3. */
+/* Count all cliques of size >= 3 by pivoting, without visiting them one
+   by one. Returns 0 and stores the count, or -1 if it exceeds 128 bits. */
+int    count_cliques_3plus_exact(const Graph *g, unsigned __int128 *count_out);
+/* Clique counts for every size in one pass: hist[k] = number of k-vertex
+   cliques. hist needs V + 2 entries. Returns omega + 1 (the entries used),
+   or -1 if some count exceeds 128 bits. */
+int    count_cliques_by_size(const Graph *g, unsigned __int128 *hist);
+/* Both counts summed over the connected components, which are counted in
+   parallel on nthreads. */
+int    count_cliques_3plus_exact_mt(const Graph *g, int nthreads, unsigned __int128 *count_out);
+int    count_cliques_by_size_mt(const Graph *g, int nthreads, unsigned __int128 *hist);
+/* Same count, or -1 if it does not fit in a long long. */
 long long count_cliques_3plus(const Graph *g);
+/* Number of triangles, split over nthreads. If per_vertex is non-NULL it
+   receives, for each of the V vertices, the triangles containing it. */
+long long count_triangles(const Graph *g, int nthreads, long long *per_vertex);
+/* Number of k-vertex cliques, split over nthreads. */
+unsigned __int128 count_kcliques(const Graph *g, int k, int nthreads);
+/* Sampled clique count with a normal-approximation confidence interval. */
+typedef struct {
+    double estimate, lo, hi;
+    long long samples;
+} CountEstimate;
+/* Estimates the number of cliques with kmin..kmax vertices (kmax = 0: no
+   upper bound), sampling until the interval at `confidence` is within
+   rel_err of the estimate or max_samples is reached. An estimate that is
+   still 0 after 65536 samples is reported as 0 without using the rest of
+   the budget. Returns 1 if the target was met, 0 if the sample budget ran
+   out first. The result depends on seed, not on nthreads. */
+int    approx_count_cliques(const Graph *g, int kmin, int kmax, double rel_err, double confidence,
+                            long long max_samples, unsigned int seed, int nthreads, CountEstimate *est);
+/* Decimal form of x; buf needs room for 40 characters. Returns buf. */
+char*  u128_to_str(unsigned __int128 x, char *buf);
+
+/* A smaller graph standing for g: reduced vertex x is original vertex
+   orig[x]. Hamilton reductions also collapse paths: x then stands for
+   chain[chain_off[x] .. chain_off[x+1]), listed from the end next to
+   original vertex chain_from[x] (-1 for single vertices). */
+typedef struct {
+    Graph *g;
+    int   *orig;
+    int   *chain_off, *chain, *chain_from;
+} GraphReduction;
+/* Keeps the vertices of core number >= lb, the only ones that can lie in
+   a clique of more than lb vertices, in increasing id order. Returns the
+   reduced V. */
+int    graph_reduce_core(const Graph *g, int lb, GraphReduction *r);
+/* Edges at a degree-2 vertex are forced; a vertex with two forced edges
+   loses the others, repeatedly, and each remaining path of degree-2
+   vertices becomes one vertex. Returns 0 with r filled (g has a
+   Hamiltonian cycle iff r->g has), or -1 if the forced edges already rule
+   one out. */
+int    graph_reduce_hamilton(const Graph *g, GraphReduction *r);
+/* Turns a Hamiltonian cycle of r->g (r->g->V vertices in cycle order)
+   into the corresponding cycle of the original graph in out. */
+void   graph_expand_cycle(const GraphReduction *r, const int *path, int *out);
+void   graph_reduction_free(GraphReduction *r);
 
+/* Returns 1 and writes a reason into why (cap bytes; may be NULL with cap
+   0) if a linear-time check proves there is no Hamiltonian cycle, else 0. */
+int    hamilton_obstruction(const Graph *g, char *why, size_t cap);
 /* Hamiltonian cycle: returns 1 and fills (cycle, len=V+1) if found; else 0. */
-int    hamilton_cycle(const Graph *g, int **cycle_out, int *cycle_len_out);
\ No newline at end of file
+int    hamilton_cycle(const Graph *g, int **cycle_out, int *cycle_len_out);
+/* Same, with the subset DP used for V <= GRAPH_HAM_DP_MAX_V (default 26,
+   at most 32) split over nthreads; larger graphs use a pruned search. Both
+   run on the graph_reduce_hamilton reduction, after hamilton_obstruction
+   finds nothing in g or in the reduced graph. */
+int    hamilton_cycle_mt(const Graph *g, int nthreads, int **cycle_out, int *cycle_len_out);
+/* Randomised heuristic: Posa rotation-extension with restarts on nthreads
+   seed streams on the graph_reduce_hamilton reduction. Returns 1 with a
+   verified cycle (as hamilton_cycle), 0 if hamilton_obstruction or the
+   reduction proves there is none (the proof used goes to why, as in
+   hamilton_obstruction), and -1 if budget_sec ran out first, which
+   decides nothing. */
+int    hamilton_posa(const Graph *g, int nthreads, unsigned int seed, double budget_sec,
+                     int **cycle_out, int *cycle_len_out, char *why, size_t cap);
@@ -1,10 +1,16 @@
 //A) Back-compat RANDOM (single header line):
-//<ALGO> <E> <V> <SEED> [-p]
+//<ALGO> <E> <V> <SEED> [flags]
 //B) Explicit GRAPH (edges follow; NOTE: order is <E> <V>):
-//<ALGO> GRAPH <E> <V> [-p]\n
+//<ALGO> GRAPH <E> <V> [flags]\n
 //(then E lines: "u v [w]\n" ; undirected; weight optional->default 1)
-//ALGO ∈ {EULER, MST, MAXCLIQUE, COUNTCLQ3P, HAMILTON}
-//Use -p to also print adjacency matrix to the client.
+//ALGO ∈ {EULER, MST, MAXCLIQUE, MAXCLIQUEBB, COUNTCLQ3P, COUNTCLQ, COUNTTRI, COUNTKCLQ <k>, HAMILTON}
+//(COUNTKCLQ takes the clique size right after its name: "COUNTKCLQ 4 GRAPH 6 5")
+//Flags: -p also prints the adjacency matrix to the client;
+//       -v adds per-vertex triangle counts to COUNTTRI;
+//       -e <rel_err> / -c <confidence> make COUNTCLQ3P and COUNTKCLQ sample
+//       an estimate instead of counting exactly (defaults 0.01 and 0.95);
+//       -t <seconds> runs HAMILTON as a randomised heuristic with that time
+//       budget; it answers with a verified cycle or "unknown", never "no".
 // Run:   ./server <port> [threads]
 
 #define _XOPEN_SOURCE 700
@@ -27,6 +33,10 @@
 
 #define BACKLOG   64
 #define MAX_LINE  8192
+#define GEN_MT_MIN_EDGES 100000   /* random graphs this large are generated in parallel */
+#define APPROX_MAX_SAMPLES (1LL << 24)  /* sample budget of one estimate */
+
+static int g_ncpu = 1;             /* online CPUs, for generation and the parallel engines */
 
 
 static int write_all(int fd, const void *buf, size_t n) {
@@ -70,6 +80,11 @@ static bool parse_uint(const char *s, unsigned int *out) {
     if (v > 0xFFFFFFFFUL) return false;
     *out = (unsigned int)v; return true;
 }
+static bool parse_double(const char *s, double *out) {
+    char *e = NULL; double v = strtod(s, &e);
+    if (e == s || *e != '\0') return false;
+    *out = v; return true;
+}
 
 typedef struct {
     char *buf; size_t len, cap;
@@ -170,7 +185,7 @@ static void ao_start(ActiveObject *ao, const char *name, AOHandler h){
 
 
 typedef enum {
-    CMD_EULER, CMD_MST, CMD_MAXCLIQUE, CMD_COUNTCLQ3P, CMD_HAMILTON
+    CMD_EULER, CMD_MST, CMD_MAXCLIQUE, CMD_MAXCLIQUEBB, CMD_COUNTCLQ3P, CMD_COUNTCLQ, CMD_COUNTTRI, CMD_COUNTKCLQ, CMD_HAMILTON
 } AlgoCmd;
 
 typedef struct {
@@ -178,6 +193,12 @@ typedef struct {
     AlgoCmd cmd;            
     Graph *g;               
     char  *prefix;          
+    bool   per_vertex;      /* -v */
+    int    k;               /* COUNTKCLQ clique size */
+    bool   approx;          /* -e / -c: sampled estimate */
+    double rel_err, confidence;
+    unsigned int seed;
+    double budget;          /* -t: HAMILTON heuristic budget in s; 0 = exact */
 } Request;
 
 typedef struct {
@@ -213,7 +234,7 @@ static void emit_and_send(Request *R, const char *body){
     free(R);
 }
 
-static ActiveObject AO_EULER, AO_MST, AO_MAXCLQ, AO_CNTCLQ3P, AO_HAM;
+static ActiveObject AO_EULER, AO_MST, AO_MAXCLQ, AO_CNTCLQ3P, AO_TRI, AO_HAM;
 
 static void handle_euler(ActiveObject *ao, void *item){
     (void)ao;
@@ -225,7 +246,7 @@ static void handle_euler(ActiveObject *ao, void *item){
         emit_and_send(R, b.buf ? b.buf : "");
         sb_free(&b); return;
     }
-    int odd = 0; for (int i=0;i<R->g->V;++i) if (degree(R->g,i)%2) odd++;
+    int odd = R->g->odd;
     if (odd) {
         sb_printf(&b, "No Euler circuit: %d vertices have odd degree.\n", odd);
         emit_and_send(R, b.buf ? b.buf : "");
@@ -248,9 +269,26 @@ static void handle_mst(ActiveObject *ao, void *item){
     (void)ao;
     Request *R = (Request*)item;
     StrBuf b; sb_init(&b);
-    long long w = mst_weight_prim(R->g);
-    if (w < 0) sb_printf(&b, "MST: graph is not connected (no spanning tree)\n");
-    else       sb_printf(&b, "MST total weight: %lld\n", w);
+    if (R->g->ncomp == 1) {
+        sb_printf(&b, "MST total weight: %lld\n", mst_weight(R->g, g_ncpu, NULL));
+        emit_and_send(R, b.buf ? b.buf : "");
+        sb_free(&b); return;
+    }
+    /* one tree per component; isolated vertices are only counted */
+    const int V = R->g->V, nc = R->g->ncomp;
+    int *comp = (int*)malloc((size_t)V * sizeof(int)), *size = (int*)calloc((size_t)nc, sizeof(int));
+    int *first = (int*)malloc((size_t)nc * sizeof(int));
+    long long *cw = (long long*)malloc((size_t)nc * sizeof(long long));
+    if (!comp || !size || !first || !cw) { perror("malloc"); exit(1); }
+    graph_components(R->g, comp);
+    long long w = mst_forest(R->g, g_ncpu, cw);
+    for (int v = V - 1; v >= 0; --v) { size[comp[v]]++; first[comp[v]] = v; }
+    sb_printf(&b, "MST: graph is not connected (%d components); minimum spanning forest:\n", nc);
+    sb_printf(&b, "Forest total weight: %lld\n", w);
+    for (int c = 0; c < nc; ++c)
+        if (size[c] > 1) sb_printf(&b, "Component %d (%d vertices, from vertex %d): weight %lld\n", c, size[c], first[c], cw[c]);
+    if (R->g->isolated) sb_printf(&b, "Isolated vertices: %d\n", R->g->isolated);
+    free(comp); free(size); free(first); free(cw);
     emit_and_send(R, b.buf ? b.buf : "");
     sb_free(&b);
 }
@@ -260,7 +298,11 @@ static void handle_maxclq(ActiveObject *ao, void *item){
     Request *R = (Request*)item;
     StrBuf b; sb_init(&b);
     int *cl = (int*)malloc((size_t)R->g->V * sizeof(int));
-    int got = 0, k = max_clique(R->g, cl, &got);
+    int got = 0;
+    /* CSR graphs are too sparse to pay for a V-bit row per vertex */
+    int k = R->g->csr                   ? max_clique_sparse(R->g, g_ncpu, cl, &got)
+          : (R->cmd == CMD_MAXCLIQUEBB) ? max_clique_bb_mt(R->g, g_ncpu, cl, &got)
+                                        : max_clique(R->g, cl, &got);
     sb_printf(&b, "Max clique size = %d\n", k);
     if (got > 0) {
         sb_printf(&b, "Vertices: ");
@@ -275,8 +317,55 @@ static void handle_cntclq3p(ActiveObject *ao, void *item){
     (void)ao;
     Request *R = (Request*)item;
     StrBuf b; sb_init(&b);
-    long long cnt = count_cliques_3plus(R->g);
-    sb_printf(&b, "Number of cliques (size >= 3): %lld\n", cnt);
+    char num[40];
+    if (R->cmd == CMD_COUNTCLQ) {
+        unsigned __int128 *hist = (unsigned __int128*)malloc(((size_t)R->g->V + 2) * sizeof(*hist)), total = 0;
+        int n = hist ? count_cliques_by_size_mt(R->g, g_ncpu, hist) : -1, over = 0;
+        if (n < 0) {
+            sb_printf(&b, "Clique counts by size: more than 2^128 cliques of some size\n");
+        } else {
+            sb_printf(&b, "Clique counts by size (k: count):\n");
+            for (int k = 3; k < n; ++k) {
+                sb_printf(&b, "%d: %s\n", k, u128_to_str(hist[k], num));
+                over |= __builtin_add_overflow(total, hist[k], &total);
+            }
+            if (over) sb_printf(&b, "Total (size >= 3): more than 2^128\n");
+            else      sb_printf(&b, "Total (size >= 3): %s\n", u128_to_str(total, num));
+        }
+        free(hist);
+    } else if (R->approx) {
+        CountEstimate e;
+        int met = approx_count_cliques(R->g, R->cmd == CMD_COUNTKCLQ ? R->k : 3, R->cmd == CMD_COUNTKCLQ ? R->k : 0,
+                                       R->rel_err, R->confidence, APPROX_MAX_SAMPLES, R->seed, g_ncpu, &e);
+        if (R->cmd == CMD_COUNTKCLQ) sb_printf(&b, "Approx. number of %d-cliques: %.6g\n", R->k, e.estimate);
+        else                         sb_printf(&b, "Approx. number of cliques (size >= 3): %.6g\n", e.estimate);
+        sb_printf(&b, "%g%% confidence interval: [%.6g, %.6g]\n", 100.0 * R->confidence, e.lo, e.hi);
+        sb_printf(&b, "Samples: %lld%s\n", e.samples, met ? "" : " (budget reached before the requested error)");
+    } else if (R->cmd == CMD_COUNTKCLQ) {
+        sb_printf(&b, "Number of %d-cliques: %s\n", R->k, u128_to_str(count_kcliques(R->g, R->k, g_ncpu), num));
+    } else {
+        unsigned __int128 cnt;
+        if (count_cliques_3plus_exact_mt(R->g, g_ncpu, &cnt) == 0)
+            sb_printf(&b, "Number of cliques (size >= 3): %s\n", u128_to_str(cnt, num));
+        else
+            sb_printf(&b, "Number of cliques (size >= 3): more than 2^128\n");
+    }
+    emit_and_send(R, b.buf ? b.buf : "");
+    sb_free(&b);
+}
+
+static void handle_tri(ActiveObject *ao, void *item){
+    (void)ao;
+    Request *R = (Request*)item;
+    StrBuf b; sb_init(&b);
+    long long *pv = R->per_vertex ? (long long*)malloc((size_t)R->g->V * sizeof(long long)) : NULL;
+    long long t = count_triangles(R->g, g_ncpu, pv);
+    sb_printf(&b, "Triangles: %lld\n", t);
+    if (pv) {
+        sb_printf(&b, "Per-vertex triangles (v: count):\n");
+        for (int v=0; v<R->g->V; ++v) sb_printf(&b, "%d: %lld\n", v, pv[v]);
+    }
+    free(pv);
     emit_and_send(R, b.buf ? b.buf : "");
     sb_free(&b);
 }
@@ -286,12 +375,29 @@ static void handle_ham(ActiveObject *ao, void *item){
     Request *R = (Request*)item;
     StrBuf b; sb_init(&b);
     int *cyc=NULL, L=0;
-    if (!hamilton_cycle(R->g, &cyc, &L)) {
-        sb_printf(&b, "No Hamiltonian cycle.\n");
+    char why[256];
+    if (hamilton_obstruction(R->g, why, sizeof(why))) {
+        sb_printf(&b, "No Hamiltonian cycle: %s.\n", why);
         emit_and_send(R, b.buf ? b.buf : "");
         sb_free(&b); return;
     }
-    sb_printf(&b, "Hamiltonian cycle found:\n");
+    if (R->budget > 0) {
+        int rc = hamilton_posa(R->g, g_ncpu, R->seed, R->budget, &cyc, &L, why, sizeof(why));
+        if (rc != 1) {
+            if (rc == 0) sb_printf(&b, "No Hamiltonian cycle: %s.\n", why);
+            else         sb_printf(&b, "Unknown: heuristic found no Hamiltonian cycle within %g s.\n", R->budget);
+            emit_and_send(R, b.buf ? b.buf : "");
+            sb_free(&b); return;
+        }
+        sb_printf(&b, "Hamiltonian cycle found (heuristic, verified):\n");
+    } else {
+        if (!hamilton_cycle_mt(R->g, g_ncpu, &cyc, &L)) {
+            sb_printf(&b, "No Hamiltonian cycle (exact search).\n");
+            emit_and_send(R, b.buf ? b.buf : "");
+            sb_free(&b); return;
+        }
+        sb_printf(&b, "Hamiltonian cycle found (exact search):\n");
+    }
     for (int i=0;i<L;++i) sb_printf(&b, "%d%s", cyc[i], (i+1==L)?"\n":" -> ");
     free(cyc);
     emit_and_send(R, b.buf ? b.buf : "");
@@ -301,9 +407,18 @@ static void handle_ham(ActiveObject *ao, void *item){
 static char* make_prefix_if_p(const Graph *g, bool want_print){
     if (!want_print) return NULL;
     StrBuf b; sb_init(&b);
+    if (g->csr) {
+        sb_printf(&b, "Graph: V=%d, E=%d\nAdjacency lists (v:w):\n", g->V, g->E);
+        for (int i=0;i<g->V;++i){
+            sb_printf(&b, "%d:", i);
+            for (int a=g->off[i];a<g->off[i+1];++a) sb_printf(&b, " %d:%d", g->nbr[a], g->nw[a]);
+            sb_printf(&b, "\n");
+        }
+        return b.buf;
+    }
     sb_printf(&b, "Graph: V=%d, E=%d\nAdjacency matrix:\n", g->V, g->E);
     for (int i=0;i<g->V;++i){
-        for (int j=0;j<g->V;++j) sb_printf(&b, "%d ", g->adj[i][j]);
+        for (int j=0;j<g->V;++j) sb_printf(&b, "%d ", graph_has_edge(g, i, j));
         sb_printf(&b, "\n");
     }
     return b.buf; 
@@ -315,14 +430,16 @@ static pthread_mutex_t lf_mtx = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t  lf_cv  = PTHREAD_COND_INITIALIZER;
 static int has_leader = 0;
 
-static pthread_mutex_t rng_mtx = PTHREAD_MUTEX_INITIALIZER;
-
 static void route_to_ao(Request *R){
     switch (R->cmd) {
         case CMD_EULER:      q_push(&AO_EULER.q, R); break;
         case CMD_MST:        q_push(&AO_MST.q, R); break;
-        case CMD_MAXCLIQUE:  q_push(&AO_MAXCLQ.q, R); break;
-        case CMD_COUNTCLQ3P: q_push(&AO_CNTCLQ3P.q, R); break;
+        case CMD_MAXCLIQUE:
+        case CMD_MAXCLIQUEBB: q_push(&AO_MAXCLQ.q, R); break;
+        case CMD_COUNTCLQ3P:
+        case CMD_COUNTCLQ:
+        case CMD_COUNTKCLQ:  q_push(&AO_CNTCLQ3P.q, R); break;
+        case CMD_COUNTTRI:   q_push(&AO_TRI.q, R); break;
         case CMD_HAMILTON:   q_push(&AO_HAM.q, R); break;
         default: 
             close(R->cfd); free_graph(R->g); free(R->prefix); free(R);
@@ -335,13 +452,22 @@ static void handle_client_header_and_dispatch(int cfd) {
     char line[MAX_LINE];
     if (read_line_req(cfd, line, sizeof(line)) <= 0) { close(cfd); return; }
 
-    char *tok[8]; int ntok=0;
-    for (char *p=strtok(line," \t\r\n"); p && ntok<8; p=strtok(NULL," \t\r\n")) tok[ntok++]=p;
+    char *tok[12]; int ntok=0;
+    for (char *p=strtok(line," \t\r\n"); p && ntok<12; p=strtok(NULL," \t\r\n")) tok[ntok++]=p;
+
+    /* COUNTKCLQ <k> ...: take k out so the rest parses like any ALGO */
+    int kclq = 0;
+    if (ntok >= 2 && strcmp(tok[0],"COUNTKCLQ")==0) {
+        if (!parse_int(tok[1], &kclq) || kclq < 1) { sendf_fd(cfd, "ERR bad <k>: COUNTKCLQ <k> ... with k >= 1\n"); close(cfd); return; }
+        memmove(&tok[1], &tok[2], (size_t)(ntok - 2) * sizeof(tok[0]));
+        --ntok;
+    }
 
     if (ntok < 4) {
         sendf_fd(cfd, "ERR usage:\n"
-                      "  <ALGO> <E> <V> <SEED> [-p]\n"
-                      "  <ALGO> GRAPH <E> <V> [-p]  (then E lines: u v [w])\n");
+                      "  <ALGO> <E> <V> <SEED> [-p] [-v] [-e <rel_err>] [-c <confidence>] [-t <seconds>]\n"
+                      "  <ALGO> GRAPH <E> <V> [-p] [-v] [-e <rel_err>] [-c <confidence>] [-t <seconds>]  (then E lines: u v [w])\n"
+                      "  (COUNTKCLQ is followed by <k> before the rest)\n");
         close(cfd); return;
     }
 
@@ -349,29 +475,54 @@ static void handle_client_header_and_dispatch(int cfd) {
     if      (strcmp(tok[0],"EULER")==0)      cmd = CMD_EULER;
     else if (strcmp(tok[0],"MST")==0)        cmd = CMD_MST;
     else if (strcmp(tok[0],"MAXCLIQUE")==0)  cmd = CMD_MAXCLIQUE;
+    else if (strcmp(tok[0],"MAXCLIQUEBB")==0) cmd = CMD_MAXCLIQUEBB;
     else if (strcmp(tok[0],"COUNTCLQ3P")==0) cmd = CMD_COUNTCLQ3P;
+    else if (strcmp(tok[0],"COUNTCLQ")==0)   cmd = CMD_COUNTCLQ;
+    else if (strcmp(tok[0],"COUNTTRI")==0)   cmd = CMD_COUNTTRI;
+    else if (strcmp(tok[0],"COUNTKCLQ")==0)  cmd = CMD_COUNTKCLQ;
     else if (strcmp(tok[0],"HAMILTON")==0)   cmd = CMD_HAMILTON;
     else {
-        sendf_fd(cfd, "ERR unknown ALGO. Supported: EULER MST MAXCLIQUE COUNTCLQ3P HAMILTON\n");
+        sendf_fd(cfd, "ERR unknown ALGO. Supported: EULER MST MAXCLIQUE MAXCLIQUEBB COUNTCLQ3P COUNTCLQ COUNTTRI COUNTKCLQ HAMILTON\n");
         close(cfd); return;
     }
 
-    bool want_print = false;
+    bool want_print = false, per_vertex = false, approx = false;
+    double rel_err = 0.01, confidence = 0.95, budget = 0;
     int E=-1, V=-1; unsigned int seed=0;
     Graph *g = NULL;
 
+    /* flags follow the 4 positional tokens in any order */
+    bool counts_cliques = (cmd == CMD_COUNTCLQ3P || cmd == CMD_COUNTKCLQ);
+    for (int i=4; i<ntok; ++i) {
+        if      (strcmp(tok[i], "-p") == 0) want_print = true;
+        else if (strcmp(tok[i], "-v") == 0 && cmd == CMD_COUNTTRI) per_vertex = true;
+        else if (strcmp(tok[i], "-e") == 0 && counts_cliques) {
+            if (i+1 >= ntok || !parse_double(tok[++i], &rel_err) || !(rel_err > 0 && rel_err < 1)) {
+                sendf_fd(cfd, "ERR -e needs a relative error in (0,1)\n"); close(cfd); return;
+            }
+            approx = true;
+        }
+        else if (strcmp(tok[i], "-c") == 0 && counts_cliques) {
+            if (i+1 >= ntok || !parse_double(tok[++i], &confidence) || !(confidence > 0 && confidence < 1)) {
+                sendf_fd(cfd, "ERR -c needs a confidence in (0,1)\n"); close(cfd); return;
+            }
+            approx = true;
+        }
+        else if (strcmp(tok[i], "-t") == 0 && cmd == CMD_HAMILTON) {
+            if (i+1 >= ntok || !parse_double(tok[++i], &budget) || !(budget > 0 && budget <= 3600)) {
+                sendf_fd(cfd, "ERR -t needs a time budget in (0,3600] seconds\n"); close(cfd); return;
+            }
+        }
+        else { sendf_fd(cfd, "ERR bad flag '%s'. Use -p (any ALGO), -v (COUNTTRI), -e/-c (COUNTCLQ3P, COUNTKCLQ), -t (HAMILTON).\n", tok[i]); close(cfd); return; }
+    }
+
     if (strcmp(tok[1], "GRAPH") == 0) {
-        if (ntok < 4 || ntok > 5) { sendf_fd(cfd, "ERR usage: <ALGO> GRAPH <E> <V> [-p]\n"); close(cfd); return; }
         if (!parse_int(tok[2], &E) || !parse_int(tok[3], &V)) { sendf_fd(cfd, "ERR bad <E> or <V>\n"); close(cfd); return; }
-        if (ntok == 5) {
-            if (strcmp(tok[4], "-p") != 0) { sendf_fd(cfd, "ERR bad flag. Use -p or omit.\n"); close(cfd); return; }
-            want_print = true;
-        }
         if (V < 1 || E < 0) { sendf_fd(cfd, "ERR invalid: V >= 1, E >= 0\n"); close(cfd); return; }
         long long maxE = (long long)V * (V - 1) / 2;
         if ((long long)E > maxE) { sendf_fd(cfd, "ERR invalid: E <= V*(V-1)/2 (max=%lld)\n", maxE); close(cfd); return; }
 
-        g = create_graph(V);
+        g = create_graph_sized(V, E);
         for (int i=0;i<E;++i){
             char el[256];
             if (read_line_req(cfd, el, sizeof(el)) <= 0) {
@@ -386,30 +537,27 @@ static void handle_client_header_and_dispatch(int cfd) {
             if (u<0||u>=V||v<0||v>=V||u==v){ sendf_fd(cfd,"ERR invalid edge %d: (%d,%d)\n",i,u,v); free_graph(g); close(cfd); return; }
             (void)graph_add_edge(g, u, v, w); // ignore duplicates
         }
+        graph_finalize(g);
     } else {
-        if (ntok < 4 || ntok > 5) { sendf_fd(cfd, "ERR usage: <ALGO> <E> <V> <SEED> [-p]\n"); close(cfd); return; }
         if (!parse_int(tok[1], &E) || !parse_int(tok[2], &V) || !parse_uint(tok[3], &seed)) {
             sendf_fd(cfd, "ERR bad params.\n"); close(cfd); return;
         }
-        if (ntok == 5) {
-            if (strcmp(tok[4], "-p") != 0) { sendf_fd(cfd, "ERR bad flag. Use -p or omit.\n"); close(cfd); return; }
-            want_print = true;
-        }
         if (V < 1 || E < 0) { sendf_fd(cfd, "ERR invalid: V >= 1, E >= 0\n"); close(cfd); return; }
         long long maxE = (long long)V * (V - 1) / 2;
         if ((long long)E > maxE) { sendf_fd(cfd, "ERR invalid: E <= V*(V-1)/2 (max=%lld)\n", maxE); close(cfd); return; }
 
-        g = create_graph(V);
-        pthread_mutex_lock(&rng_mtx);
-        generate_random_graph(g, E, seed);
-        pthread_mutex_unlock(&rng_mtx);
+        g = create_graph_sized(V, E);
+        generate_random_graph_mt(g, E, seed, E >= GEN_MT_MIN_EDGES ? g_ncpu : 1);
     }
 
     char *prefix = make_prefix_if_p(g, want_print);
 
     Request *R = (Request*)malloc(sizeof(Request));
     if (!R) { perror("malloc"); free_graph(g); free(prefix); close(cfd); return; }
-    R->cfd = cfd; R->cmd = cmd; R->g = g; R->prefix = prefix;
+    R->cfd = cfd; R->cmd = cmd; R->g = g; R->prefix = prefix; R->per_vertex = per_vertex;
+    R->k = kclq;
+    R->approx = approx; R->rel_err = rel_err; R->confidence = confidence; R->seed = seed;
+    R->budget = budget;
 
     route_to_ao(R);
 }
@@ -452,12 +600,17 @@ int main(int argc, char **argv){
         nthreads = (n > 0) ? (int)n : 4;
     }
     if (nthreads < 1) nthreads = 1;
+    {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        g_ncpu = (n > 0) ? (int)n : 1;
+    }
 
     ao_start(&AO_SENDER,   "SENDER",      handle_send);
     ao_start(&AO_EULER,    "EULER_AO",    handle_euler);
     ao_start(&AO_MST,      "MST_AO",      handle_mst);
     ao_start(&AO_MAXCLQ,   "MAXCLIQUE_AO",handle_maxclq);
     ao_start(&AO_CNTCLQ3P, "COUNTCLQ3P_AO",handle_cntclq3p);
+    ao_start(&AO_TRI,      "COUNTTRI_AO", handle_tri);
     ao_start(&AO_HAM,      "HAMILTON_AO", handle_ham);
 
     g_listen_fd = socket(AF_INET, SOCK_STREAM, 0);